@@ -0,0 +1,223 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <set>
+#include <stdexcept>
+
+#include "cbs.h"
+#include "distance_table.h"
+#include "lns.h"
+#include "portfolio.h"
+#include "stats.h"
+#include "thread_pool.h"
+#include "windowed.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    struct BatchJob {
+        fs::path input;
+        fs::path output;
+        uintmax_t size; // of the input file, the largest ones are started first
+    };
+
+    struct BatchResult {
+        const char *status{"not run"};
+        size_t makespan{0};
+        double seconds{0.0};
+        uint64_t nodes_expanded{0};
+    };
+
+    /*
+     * Lists the instances of a directory or a manifest.
+     * @return false if there is neither, the reason has been printed already
+     */
+    bool list_jobs(const Options &options, std::vector<BatchJob> &jobs) {
+        const fs::path source{options.input_file};
+        std::error_code error;
+        std::vector<fs::path> inputs;
+        if (fs::is_directory(source, error)) {
+            for (const auto &entry : fs::directory_iterator(source, error)) {
+                if (entry.is_regular_file(error)) {
+                    inputs.push_back(entry.path());
+                }
+            }
+            std::sort(inputs.begin(), inputs.end());
+        } else {
+            error.clear();
+            std::ifstream manifest(source);
+            if (!manifest) {
+                std::cout << "Batch: cannot open " << options.input_file << "\n";
+                return false;
+            }
+            std::string line;
+            while (std::getline(manifest, line)) {
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                if (!line.empty() && line.front() != '#') {
+                    inputs.push_back(source.parent_path() / line);
+                }
+            }
+        }
+        if (error) {
+            std::cout << "Batch: cannot list " << options.input_file << ": " << error.message() << "\n";
+            return false;
+        }
+
+        std::set<fs::path> names;
+        for (const auto &input : inputs) {
+            if (!names.insert(input.filename()).second) {
+                std::cout << "Batch: two instances are named " << input.filename() << ", their solutions would "
+                          << "overwrite each other\n";
+                return false;
+            }
+            const auto size = fs::file_size(input, error);
+            jobs.push_back({input, fs::path(options.output_file) / input.filename(), error ? 0 : size});
+        }
+        return true;
+    }
+
+    BatchResult run_job(const BatchJob &job, const Options &options) {
+        using Clock = std::chrono::steady_clock;
+        const auto begin = Clock::now();
+        const auto expanded_before = thread_stats().nodes_expanded;
+
+        BatchResult result;
+        Instance inst;
+        bool parsed;
+        {
+            PhaseTimer timer(Phase::Parse);
+            parsed = parse_instance(job.input.string(), inst);
+        }
+        // parse_instance also turns down instances that are well formed but can't be solved, like ones without chargers
+        if (!parsed) {
+            result.status = "invalid";
+        } else {
+            const DistanceTable distances = [&inst, &options] {
+                PhaseTimer timer(Phase::Preprocess);
+                return DistanceTable(inst, options.layout_cache, options.field_memory);
+            }();
+            ThreadPool inline_pool(1);
+            MoveStrings move_strings;
+            if (!solve_instance(inst, distances, options, inline_pool, move_strings)) {
+                result.status = "unsolved";
+            } else {
+                PhaseTimer timer(Phase::Output);
+                result.makespan = makespan(move_strings);
+                result.status = write_solution(move_strings, job.output.string(), options.output_format)
+                                ? "solved" : "unwritten";
+            }
+        }
+
+        result.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+        result.nodes_expanded = thread_stats().nodes_expanded - expanded_before;
+        return result;
+    }
+
+    /*
+     * Quotes s if it would break the line up into more fields.
+     */
+    std::string csv_field(const std::string &s) {
+        if (s.find_first_of(",\"\n") == std::string::npos) {
+            return s;
+        }
+        std::string quoted{"\""};
+        for (const auto c : s) {
+            quoted += c == '"' ? "\"\"" : std::string(1, c);
+        }
+        return quoted + "\"";
+    }
+}
+
+bool solve_instance(const Instance &inst, const DistanceTable &distances, const Options &options, ThreadPool &pool,
+                    MoveStrings &move_strings) {
+    Routes routes; // stays empty for cbs and windowed, there is nothing to improve on then
+    bool solved{false};
+    if (options.solver == SolverKind::Cbs) {
+        PhaseTimer timer(Phase::Cbs);
+        solved = solve_cbs(inst, distances, options, pool, move_strings);
+        if (!solved) {
+            std::cout << "Falling back to the greedy solver\n";
+        }
+    }
+    if (options.solver == SolverKind::Windowed) {
+        PhaseTimer timer(Phase::Windowed);
+        solved = solve_windowed(inst, distances, options, move_strings);
+        if (!solved) {
+            std::cout << "Falling back to the greedy solver\n";
+        }
+    }
+    if (options.solver == SolverKind::Portfolio) {
+        PhaseTimer timer(Phase::Portfolio);
+        solved = solve_portfolio(inst, distances, options, move_strings, routes);
+    }
+    if (!solved) {
+        SolveVariant variant;
+        variant.seed = std::random_device{}();
+        variant.routes = &routes;
+        if (!solve_prioritized(inst, distances, options, pool, variant, move_strings)) {
+            return false;
+        }
+    }
+    if (options.improve_time > 0.0 && !routes.empty()) {
+        PhaseTimer timer(Phase::Improvement);
+        improve_solution(inst, distances, options, routes, move_strings);
+    }
+    return true;
+}
+
+bool run_batch(const Options &options) {
+    std::vector<BatchJob> jobs;
+    if (!list_jobs(options, jobs)) {
+        return false;
+    }
+    std::error_code error;
+    fs::create_directories(options.output_file, error);
+    const auto summary_file = fs::path(options.output_file) / "summary.csv";
+    std::ofstream summary(summary_file);
+    if (error || !summary) {
+        std::cout << "Batch: cannot write into " << options.output_file << "\n";
+        return false;
+    }
+
+    // the threads take part in the batch, every instance is solved on a single one
+    auto job_options = options;
+    job_options.threads = 1;
+    std::vector<size_t> order(jobs.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::stable_sort(order.begin(), order.end(), [&jobs](size_t j1, size_t j2) {
+        return jobs[j1].size > jobs[j2].size;
+    });
+    std::vector<BatchResult> results(jobs.size());
+    {
+        ThreadPool pool(options.threads);
+        pool.parallel_for(jobs.size(), [&](size_t k) {
+            // an exception must not leave the worker thread, it would end the whole batch
+            try {
+                results[order[k]] = run_job(jobs[order[k]], job_options);
+            } catch (const std::exception &e) {
+                std::cout << "Batch: " << jobs[order[k]].input.string() << " failed: " << e.what() << "\n";
+                results[order[k]].status = "error";
+            }
+        });
+    }
+
+    summary << "instance,status,makespan,seconds,nodes_expanded\n";
+    size_t solved{0};
+    for (size_t k{0}; k < jobs.size(); ++k) {
+        const auto &r = results[k];
+        summary << csv_field(jobs[k].input.string()) << "," << r.status << "," << r.makespan << "," << r.seconds
+                << "," << r.nodes_expanded << "\n";
+        solved += std::string(r.status) == "solved" ? 1 : 0;
+    }
+    std::cout << "Batch: " << solved << " of " << jobs.size() << " instances solved, summary in "
+              << summary_file.string() << "\n";
+    return true;
+}
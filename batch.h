@@ -0,0 +1,34 @@
+#ifndef MAPF_BATCH_H
+#define MAPF_BATCH_H
+
+#include "input_parsing.h"
+#include "options.h"
+#include "solver.h"
+
+class DistanceTable;
+class ThreadPool;
+
+/*
+ * Solves an instance with the solver of options, falling back to the greedy one where that gives up, and improves
+ * the solution afterwards if options.improve_time is set. Shared by the single instance and the batch mode.
+ * @return false if no solution was found, the reason has been printed already
+ */
+bool solve_instance(const Instance &inst, const DistanceTable &distances, const Options &options, ThreadPool &pool,
+                    MoveStrings &move_strings);
+
+/*
+ * Batch mode: options.input_file is a directory, every file in it is an instance, or a manifest with the path of one
+ * instance per line (relative to the manifest, empty lines and lines starting with '#' are skipped). The instances are
+ * solved on options.threads threads, one instance per thread at a time and the largest files first. Every solution is
+ * written into the directory options.output_file under the file name of its instance, and summary.csv there gets a
+ * line 'instance,status,makespan,seconds,nodes_expanded' per instance in the order they were listed. Every instance is
+ * validated before it is solved, one that is invalid (see parse_instance), can't be solved or fails otherwise only
+ * shows up with its status 'invalid', 'unsolved', 'unwritten' or 'error', the others are solved anyway.
+ *
+ * The nodes are the ones expanded by the thread that solved the instance, the portfolio solver expands its nodes on
+ * threads of its own.
+ * @return false if the batch could not be run at all, the reason has been printed already
+ */
+bool run_batch(const Options &options);
+
+#endif //MAPF_BATCH_H
@@ -0,0 +1,355 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "compact_path.h"
+#include "distance_table.h"
+#include "hpa.h"
+#include "input_parsing.h"
+#include "instance_generator.h"
+#include "options.h"
+#include "pathfinding.h"
+#include "reservation_table.h"
+#include "search_context.h"
+#include "sipp.h"
+#include "solver.h"
+#include "stats.h"
+#include "thread_pool.h"
+#include "windowed.h"
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    /* What a benchmark reports besides its time, summed over all operations.
+     */
+    struct Counters {
+        uint64_t nodes{0};
+        int64_t makespan{-1};
+        uint64_t failures{0};
+    };
+
+    struct BenchConfig {
+        std::string filter;
+        double min_seconds{0.5};
+    };
+
+    /* Drops everything written to it without keeping any of it.
+     */
+    class NullBuffer : public std::streambuf {
+    protected:
+        int_type overflow(int_type c) override {
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char *, std::streamsize n) override {
+            return n;
+        }
+    };
+
+    /* Swallows everything the solver prints while it is timed.
+     */
+    class QuietOutput {
+    public:
+        QuietOutput() : m_old(std::cout.rdbuf(&m_sink)) {}
+
+        ~QuietOutput() {
+            std::cout.rdbuf(m_old);
+        }
+
+    private:
+        NullBuffer m_sink;
+        std::streambuf *m_old;
+    };
+
+    // the tie break and find_actions of the solver are seeded with it, so every run reports the same makespan
+    constexpr uint32_t bench_seed{1};
+
+    /*
+     * Runs op (which does one operation per call) until min_seconds are over and prints the time per operation.
+     */
+    void run(const BenchConfig &config, const std::string &name, const std::function<void(Counters &)> &op) {
+        if (name.find(config.filter) == std::string::npos) {
+            return;
+        }
+        Counters counters;
+        uint64_t iterations{0};
+        double seconds{0.0};
+        {
+            QuietOutput quiet;
+            const auto begin = Clock::now();
+            do {
+                op(counters);
+                ++iterations;
+                seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+            } while (seconds < config.min_seconds);
+        }
+
+        const auto per_op = seconds / static_cast<double>(iterations);
+        std::printf("%-36s %10llu %12.3f us/op", name.c_str(), static_cast<unsigned long long>(iterations),
+                    per_op * 1e6);
+        if (counters.nodes > 0) {
+            std::printf(" %12.1f nodes/op", static_cast<double>(counters.nodes) / static_cast<double>(iterations));
+        }
+        if (counters.makespan >= 0) {
+            std::printf(" %8lld makespan", static_cast<long long>(counters.makespan));
+        }
+        if (counters.failures > 0) {
+            std::printf(" %llu failed", static_cast<unsigned long long>(counters.failures));
+        }
+        std::printf("\n");
+    }
+
+    std::string write_temp_instance(const std::string &name, const std::string &contents) {
+        const auto filename = "/tmp/mapf_bench_" + name + ".txt";
+        std::ofstream(filename) << contents;
+        return filename;
+    }
+
+    /* A grid with some robot paths reserved already, like in the middle of solving.
+     */
+    struct Scenario {
+        int32_t size;
+        ReservationTable reservations;
+        std::vector<std::pair<SpaceTimePoint, SpacePoint>> queries;
+
+        Scenario(int32_t size, int32_t reserved_paths, uint32_t seed) : size{size}, reservations(size, size) {
+            std::mt19937 rng{seed};
+            std::uniform_int_distribution<int32_t> coordinate(0, size - 1);
+            for (int32_t k{0}; k < reserved_paths; ++k) {
+                const SpaceTimePoint start(coordinate(rng), coordinate(rng), 0);
+                const SpacePoint goal(coordinate(rng), coordinate(rng));
+                const auto path = a_star(start, goal, 1, 4 * size, size, size, reservations);
+                for (const auto p : path) {
+                    reservations.reserve(p);
+                }
+            }
+            for (int32_t k{0}; k < 64; ++k) {
+                queries.emplace_back(SpaceTimePoint(coordinate(rng), coordinate(rng), 0),
+                                     SpacePoint(coordinate(rng), coordinate(rng)));
+            }
+        }
+    };
+
+    void bench_get_neighbours(const BenchConfig &config) {
+        const Scenario scenario(64, 32, 1);
+        size_t k{0};
+        run(config, "get_neighbours/64x64", [&](Counters &) {
+            // 256 calls per operation, one call is too short to time
+            for (size_t i{0}; i < 256; ++i, ++k) {
+                const auto x = static_cast<int32_t>(k % 64);
+                const auto y = static_cast<int32_t>((k / 64) % 64);
+                const auto t = static_cast<int32_t>(k % 200);
+                const auto n = get_neighbours(SpaceTimePoint(x, y, t), scenario.reservations);
+                if (n.count > 5) {
+                    std::abort();
+                }
+            }
+        });
+    }
+
+    void bench_planner(const BenchConfig &config, const std::string &name, PathPlanner planner, int32_t size) {
+        const Scenario scenario(size, size / 2, 2);
+        SearchContext context;
+        size_t k{0};
+        run(config, name + "/" + std::to_string(size) + "x" + std::to_string(size), [&](Counters &counters) {
+            const auto &q = scenario.queries[k++ % scenario.queries.size()];
+            planner(q.first, q.second, 1, 4 * size, size, size, scenario.reservations, nullptr, context);
+            counters.nodes += context.size();
+        });
+    }
+
+    /*
+     * Planners that need the distance table of an instance, on an empty grid of the same size as the scenario.
+     */
+    void bench_table_planner(const BenchConfig &config, const std::string &name, PathPlanner planner, int32_t size) {
+        const Scenario scenario(size, size / 2, 2);
+        Instance inst{};
+        inst.width = size;
+        inst.height = size;
+        const DistanceTable distances(inst);
+        distances.clusters(); // built once before, not during the first operation
+        SearchContext context;
+        size_t k{0};
+        run(config, name + "/" + std::to_string(size) + "x" + std::to_string(size), [&](Counters &counters) {
+            const auto &q = scenario.queries[k++ % scenario.queries.size()];
+            const auto expanded = thread_stats().nodes_expanded;
+            planner(q.first, q.second, 1, 4 * size, size, size, scenario.reservations, &distances, context);
+            counters.nodes += thread_stats().nodes_expanded - expanded;
+        });
+    }
+
+    void bench_reconstruct_path(const BenchConfig &config) {
+        const Scenario scenario(128, 64, 3);
+        SearchContext context;
+        // the longest of the queries
+        CompactPath longest;
+        SpaceTimePoint goal;
+        for (const auto &q : scenario.queries) {
+            auto path = a_star(q.first, q.second, 1, 512, 128, 128, scenario.reservations, nullptr, context);
+            if (path.size() > longest.size()) {
+                longest = path;
+                goal = path.back();
+            }
+        }
+        a_star(longest.front(), SpacePoint(goal), 1, 512, 128, 128, scenario.reservations, nullptr, context);
+        const auto goal_id = context.find(goal);
+        run(config, "reconstruct_path/" + std::to_string(longest.size()) + "_steps", [&](Counters &counters) {
+            counters.nodes += reconstruct_path(context, goal_id).size();
+        });
+    }
+
+    void bench_find_actions(const BenchConfig &config) {
+        const Scenario scenario(64, 32, 4);
+        std::mt19937 rng{5};
+        size_t k{0};
+        run(config, "find_actions/64x64_50_steps", [&](Counters &) {
+            const auto &q = scenario.queries[k++ % scenario.queries.size()];
+            CompactPath path;
+            find_actions(q.first, 200, 50, scenario.reservations, rng, path);
+        });
+    }
+
+    void bench_parse_instance(const BenchConfig &config, const GeneratorConfig &generator, const std::string &name) {
+        const auto filename = write_temp_instance(name, generate_instance(generator));
+        run(config, "parse_instance/" + name, [&](Counters &) {
+            Instance inst;
+            if (!parse_instance(filename, inst) || inst.width != generator.width) {
+                std::abort();
+            }
+        });
+        std::remove(filename.c_str());
+    }
+
+    void bench_preprocess(const BenchConfig &config, const GeneratorConfig &generator, const std::string &name) {
+        const auto filename = write_temp_instance(name, generate_instance(generator));
+        Instance inst;
+        if (!parse_instance(filename, inst)) {
+            std::abort();
+        }
+        std::remove(filename.c_str());
+        run(config, "preprocess/" + name + "/no_cache", [&](Counters &) {
+            const DistanceTable distances(inst);
+        });
+        // the first run writes the layout, all timed ones map it
+        const std::string cache_dir{"/tmp/mapf_bench_layouts"};
+        {
+            const DistanceTable distances(inst, cache_dir);
+        }
+        run(config, "preprocess/" + name + "/warm_cache", [&](Counters &) {
+            const DistanceTable distances(inst, cache_dir);
+        });
+        std::error_code error;
+        std::filesystem::remove_all(cache_dir, error);
+    }
+
+    void bench_solve(const BenchConfig &config, const GeneratorConfig &generator, const std::string &name,
+                     PlannerKind planner, SolverKind solver = SolverKind::Greedy) {
+        const auto filename = write_temp_instance(name, generate_instance(generator));
+        Instance inst;
+        {
+            QuietOutput quiet;
+            if (!parse_instance(filename, inst)) {
+                std::abort();
+            }
+        }
+        std::remove(filename.c_str());
+        const DistanceTable distances(inst);
+        Options options;
+        options.planner = planner;
+        options.solver = solver;
+        ThreadPool pool(1);
+        const auto kind = solver == SolverKind::Windowed ? "/windowed"
+                          : planner == PlannerKind::Sipp ? "/sipp" : "/astar";
+        run(config, std::string("solve/") + name + kind,
+            [&](Counters &counters) {
+                MoveStrings move_strings;
+                SolveVariant variant;
+                variant.seed = bench_seed;
+                const auto solved = solver == SolverKind::Windowed
+                                    ? solve_windowed(inst, distances, options, variant, move_strings)
+                                    : solve_prioritized(inst, distances, options, pool, variant, move_strings);
+                if (!solved) {
+                    ++counters.failures;
+                    return;
+                }
+                int64_t makespan{0};
+                for (const auto &m : move_strings) {
+                    makespan = std::max(makespan, static_cast<int64_t>(m.second.size()));
+                }
+                counters.makespan = makespan;
+            });
+    }
+
+    bool generate(int argc, char *argv[]) {
+        if (argc != 10) {
+            return false;
+        }
+        GeneratorConfig generator{};
+        int32_t *values[] = {&generator.width, &generator.height, &generator.robots, &generator.shelves,
+                             &generator.chargers, &generator.packages};
+        for (size_t k{0}; k < 6; ++k) {
+            *values[k] = std::atoi(argv[2 + k]);
+        }
+        generator.seed = static_cast<uint32_t>(std::strtoul(argv[8], nullptr, 10));
+        const auto contents = generate_instance(generator);
+        if (contents.empty()) {
+            std::cout << "Invalid generator parameters\n";
+            return false;
+        }
+        std::ofstream(argv[9]) << contents;
+        return true;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "generate") {
+        if (!generate(argc, argv)) {
+            std::cout << "Call as './mapf_bench generate <width> <height> <robots> <shelves> <chargers> <packages> "
+                         "<seed> <output file>'\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    BenchConfig config;
+    for (int i{1}; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        if (arg == "--filter" && i + 1 < argc) {
+            config.filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            config.min_seconds = std::atof(argv[++i]);
+        } else {
+            std::cout << "Call as './mapf_bench [--filter <substring>] [--min-time <seconds>]' or "
+                         "'./mapf_bench generate ...'\n";
+            return 1;
+        }
+    }
+
+    std::printf("%-36s %10s %15s\n", "benchmark", "iterations", "time");
+    bench_get_neighbours(config);
+    bench_planner(config, "a_star", a_star, 64);
+    bench_planner(config, "a_star", a_star, 256);
+    bench_planner(config, "sipp", sipp, 64);
+    bench_planner(config, "sipp", sipp, 256);
+    bench_table_planner(config, "a_star_table", a_star, 256);
+    bench_table_planner(config, "hpa", a_star_hierarchical, 256);
+    bench_table_planner(config, "a_star_table", a_star, 1024);
+    bench_table_planner(config, "hpa", a_star_hierarchical, 1024);
+    bench_reconstruct_path(config);
+    bench_find_actions(config);
+    bench_parse_instance(config, {64, 64, 10, 26, 8, 200, 6}, "64x64");
+    bench_parse_instance(config, {1000, 1000, 500, 300, 50, 5000, 7}, "1000x1000");
+    bench_preprocess(config, {512, 512, 10, 100, 10, 10, 7}, "512x512");
+    bench_solve(config, {30, 20, 6, 20, 4, 20, 8}, "30x20_6r_20p", PlannerKind::AStar);
+    bench_solve(config, {30, 20, 6, 20, 4, 20, 8}, "30x20_6r_20p", PlannerKind::Sipp);
+    bench_solve(config, {60, 40, 10, 26, 8, 40, 9}, "60x40_10r_40p", PlannerKind::Sipp);
+    bench_solve(config, {60, 40, 10, 26, 8, 40, 9}, "60x40_10r_40p", PlannerKind::AStar, SolverKind::Windowed);
+    return 0;
+}
@@ -0,0 +1,411 @@
+#include "cbs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <set>
+
+#include "delivery_planning.h"
+#include "distance_table.h"
+#include "reservation_table.h"
+#include "search_context.h"
+#include "task_allocation.h"
+#include "thread_pool.h"
+
+namespace {
+    /* The deliveries of one robot and where it is at every time step. Once the route is done the robot stays on the
+     * last field.
+     */
+    struct Route {
+        std::vector<DeliveryPlan> plans;
+        CompactPath to_home; // empty unless the robot has to leave its last field again
+        std::vector<SpacePoint> positions;
+    };
+
+    /* The robot has to treat the field of point as reserved by someone else from point.t to until. If go_home is set
+     * the robot may not park where its last delivery ended but returns to its start field, which nobody else needs.
+     * The constraints of a node form a chain up to the root.
+     */
+    struct Constraint {
+        size_t robot;
+        SpaceTimePoint point;
+        int32_t until;
+        bool go_home;
+        std::shared_ptr<const Constraint> parent;
+    };
+
+    /* robot_1 at point_1 and robot_2 at point_2 are on the same field at most one time step apart.
+     */
+    struct Conflict {
+        size_t robot_1;
+        SpaceTimePoint point_1;
+        size_t robot_2;
+        SpaceTimePoint point_2;
+    };
+
+    struct Node {
+        std::vector<std::shared_ptr<const Route>> routes; // unchanged routes are shared with the parent
+        std::shared_ptr<const Constraint> constraints;
+        int32_t makespan;
+        int64_t cost; // summed route lengths
+        size_t conflicts; // number of conflicting pairs of points
+        Conflict conflict; // the earliest one
+    };
+
+    using NodePtr = std::shared_ptr<const Node>;
+
+    struct ByCost {
+        bool operator()(const NodePtr &n1, const NodePtr &n2) const {
+            if (n1->makespan != n2->makespan) {
+                return n1->makespan < n2->makespan;
+            }
+            if (n1->cost != n2->cost) {
+                return n1->cost < n2->cost;
+            }
+            return n1.get() < n2.get();
+        }
+    };
+
+    struct ByConflicts {
+        bool operator()(const NodePtr &n1, const NodePtr &n2) const {
+            if (n1->conflicts != n2->conflicts) {
+                return n1->conflicts < n2->conflicts;
+            }
+            return ByCost{}(n1, n2);
+        }
+    };
+
+    /* Open list of a focal search (ECBS): among the nodes whose makespan is within suboptimality of the best open one,
+     * the one with the fewest conflicts is expanded first. With a suboptimality of 1 there is no focal list, the nodes
+     * are expanded by makespan and cost alone like in plain best first CBS.
+     */
+    class FocalList {
+    public:
+        explicit FocalList(double suboptimality)
+                : m_suboptimality(suboptimality), m_focal_search{suboptimality > 1.0}, m_bound(-1) {}
+
+        bool empty() const {
+            return m_open.empty();
+        }
+
+        void push(NodePtr node) {
+            if (!m_focal_search) {
+                m_open.insert(std::move(node));
+                return;
+            }
+            if (node->makespan <= m_bound) {
+                m_focal.insert(node);
+            }
+            m_open.insert(std::move(node));
+            update_bound();
+        }
+
+        NodePtr pop() {
+            if (!m_focal_search) {
+                auto node = *m_open.begin();
+                m_open.erase(m_open.begin());
+                return node;
+            }
+            auto node = *m_focal.begin();
+            m_focal.erase(m_focal.begin());
+            m_open.erase(node);
+            update_bound();
+            return node;
+        }
+
+    private:
+        void update_bound() {
+            if (m_open.empty()) {
+                return;
+            }
+            const auto bound = static_cast<int32_t>((*m_open.begin())->makespan * m_suboptimality);
+            if (bound <= m_bound) {
+                return;
+            }
+            for (auto it = m_open.begin(); it != m_open.end() && (*it)->makespan <= bound; ++it) {
+                if ((*it)->makespan > m_bound) {
+                    m_focal.insert(*it);
+                }
+            }
+            m_bound = bound;
+        }
+
+        double m_suboptimality;
+        bool m_focal_search; // false for plain best first CBS, m_focal stays empty then
+        int32_t m_bound; // nodes with a makespan up to here are in focal
+        std::set<NodePtr, ByCost> m_open;
+        std::set<NodePtr, ByConflicts> m_focal;
+    };
+
+    /* Read only data shared by all nodes.
+     */
+    struct Problem {
+        const Instance &inst;
+        const DistanceTable &distances;
+        PathPlanner plan_path;
+        std::vector<RobotState> robots;
+        std::vector<std::vector<const DeliveryTask *>> tasks; // per robot, in the order they are done
+    };
+
+    SpacePoint position_at(const Route &route, int32_t t) {
+        return route.positions[std::min(static_cast<size_t>(t), route.positions.size() - 1)];
+    }
+
+    void append_positions(const CompactPath &path, std::vector<SpacePoint> &positions) {
+        for (const auto p : path) {
+            // rest periods aren't part of the paths, the robot stays where it was
+            while (static_cast<int32_t>(positions.size()) < p.t) {
+                positions.push_back(positions.back());
+            }
+            if (static_cast<int32_t>(positions.size()) == p.t) {
+                positions.emplace_back(p);
+            }
+        }
+    }
+
+    bool plan_robot(const Problem &problem, size_t robot, const Constraint *constraints, Route &route) {
+        const auto &inst = problem.inst;
+        ReservationTable reservations(problem.distances.grid());
+        bool go_home{false};
+        for (auto c = constraints; c; c = c->parent.get()) {
+            if (c->robot == robot) {
+                go_home = go_home || c->go_home;
+                for (auto t = c->point.t; t <= c->until; ++t) {
+                    reservations.reserve(c->point.x, c->point.y, t);
+                }
+            }
+        }
+
+        if (!plan_route(problem.robots[robot], problem.tasks[robot], inst, problem.distances, reservations,
+                        problem.plan_path, default_search_context(), route.plans)) {
+            return false;
+        }
+
+        const auto home = problem.robots[robot].endpoint;
+        route.positions.assign(1, SpacePoint(home));
+        for (const auto &plan : route.plans) {
+            append_positions(plan.to_start, route.positions);
+            append_positions(plan.to_charge_1, route.positions);
+            append_positions(plan.to_goal, route.positions);
+            append_positions(plan.to_charge_2, route.positions);
+            append_positions(CompactPath(plan.endpoint), route.positions);
+        }
+
+        route.to_home.clear();
+        if (go_home && !route.plans.empty()) {
+            const auto &last = route.plans.back();
+            route.to_home = problem.plan_path(last.endpoint, SpacePoint(home), 1, last.charge, inst.width, inst.height,
+                                              reservations, &problem.distances, default_search_context());
+            if (route.to_home.empty()) {
+                return false;
+            }
+            append_positions(route.to_home, route.positions);
+        }
+        return true;
+    }
+
+    /*
+     * Sets makespan, cost and the conflicts of node from its routes.
+     */
+    void evaluate(const Problem &problem, Node &node) {
+        node.makespan = 0;
+        node.cost = 0;
+        for (const auto &r : node.routes) {
+            const auto length = static_cast<int32_t>(r->positions.size()) - 1;
+            node.makespan = std::max(node.makespan, length);
+            node.cost += length;
+        }
+
+        // who was on a field last and when, a conflict is someone else there at most one step later
+        const auto cells = static_cast<size_t>(problem.inst.width) * static_cast<size_t>(problem.inst.height);
+        std::vector<int32_t> owner(cells, -1);
+        std::vector<int32_t> owner_time(cells, 0);
+        node.conflicts = 0;
+        for (int32_t t{0}; t <= node.makespan; ++t) {
+            for (size_t r{0}; r < node.routes.size(); ++r) {
+                const auto p = position_at(*node.routes[r], t);
+                const auto cell = static_cast<size_t>(p.y) * problem.inst.width + p.x;
+                if (owner[cell] >= 0 && static_cast<size_t>(owner[cell]) != r && owner_time[cell] >= t - 1) {
+                    if (node.conflicts == 0) {
+                        node.conflict = Conflict{static_cast<size_t>(owner[cell]),
+                                                 SpaceTimePoint(p.x, p.y, owner_time[cell]), r,
+                                                 SpaceTimePoint(p.x, p.y, t)};
+                    }
+                    ++node.conflicts;
+                }
+                owner[cell] = static_cast<int32_t>(r);
+                owner_time[cell] = t;
+            }
+        }
+    }
+
+    bool is_parked(const Route &route, int32_t t) {
+        return static_cast<size_t>(t) >= route.positions.size();
+    }
+
+    /*
+     * Replans robot so it stays clear of the field other is on at avoid, for as long as other stays there (for the rest
+     * of the parent's makespan if other is parked). Constraining whole stays instead of single time steps resolves a
+     * robot resting on a charger in one branch instead of one per step. If robot is parked at own it goes home after
+     * its deliveries.
+     * @return false if that isn't possible or the robot would still be in the way
+     */
+    bool make_child(const Problem &problem, const Node &parent, size_t robot, SpaceTimePoint own, size_t other,
+                    SpaceTimePoint avoid, NodePtr &child) {
+        const bool go_home = is_parked(*parent.routes[robot], own.t);
+        if (go_home && !parent.routes[robot]->to_home.empty()) {
+            return false; // already at home, parked robots can't be moved any further
+        }
+
+        const auto &other_route = *parent.routes[other];
+        const SpacePoint field(avoid);
+        const auto last = static_cast<int32_t>(other_route.positions.size()) - 1;
+        avoid.t = std::min(avoid.t, last);
+        while (avoid.t > 0 && other_route.positions[avoid.t - 1] == field) {
+            --avoid.t;
+        }
+        auto until = avoid.t;
+        while (until < last && other_route.positions[until + 1] == field) {
+            ++until;
+        }
+        if (until == last) {
+            until = std::max(parent.makespan, own.t) + 1;
+        }
+        auto constraint = std::make_shared<const Constraint>(Constraint{robot, avoid, until, go_home,
+                                                                                parent.constraints});
+        auto route = std::make_shared<Route>();
+        if (!plan_robot(problem, robot, constraint.get(), *route)) {
+            return false;
+        }
+        for (auto t = std::max(0, avoid.t - 1); t <= until + 1; ++t) {
+            if (position_at(*route, t) == field) {
+                return false;
+            }
+        }
+
+        auto node = std::make_shared<Node>();
+        node->routes = parent.routes;
+        node->routes[robot] = std::move(route);
+        node->constraints = std::move(constraint);
+        evaluate(problem, *node);
+        child = std::move(node);
+        return true;
+    }
+}
+
+bool solve_cbs(const Instance &inst, const DistanceTable &distances, const Options &options, ThreadPool &pool,
+               MoveStrings &move_strings) {
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options.time_limit));
+
+    Problem problem{inst, distances, select_planner(options.planner), {}, {}};
+    for (const auto &p : inst.robot_positions) {
+        problem.robots.push_back({p.first, inst.charge, SpaceTimePoint(p.second)});
+    }
+
+    std::vector<DeliveryTask> tasks;
+    for (const auto &d : inst.deliveries) {
+        tasks.push_back(make_delivery_task(d, inst, distances));
+    }
+    // the routes are fixed per robot, so the deliveries have to be assigned to robots up front
+    const auto allocation = options.allocation == AllocationKind::Greedy ? AllocationKind::Auction : options.allocation;
+    problem.tasks.resize(problem.robots.size());
+    for (const auto &a : allocate_deliveries(allocation, problem.robots, tasks, distances)) {
+        for (size_t r{0}; r < problem.robots.size(); ++r) {
+            if (problem.robots[r].id == a.robot_id) {
+                problem.tasks[r].push_back(&tasks[a.delivery]);
+            }
+        }
+    }
+
+    // root: every robot on its own
+    auto root = std::make_shared<Node>();
+    root->routes.resize(problem.robots.size());
+    std::vector<char> root_found(problem.robots.size());
+    pool.parallel_for(problem.robots.size(), [&](size_t r) {
+        auto route = std::make_shared<Route>();
+        root_found[r] = plan_robot(problem, r, nullptr, *route);
+        root->routes[r] = std::move(route);
+    });
+    if (std::find(root_found.begin(), root_found.end(), 0) != root_found.end()) {
+        std::cout << "CBS: not every robot can do its deliveries on its own\n";
+        return false;
+    }
+    evaluate(problem, *root);
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    FocalList open(options.suboptimality);
+    open.push(std::move(root));
+    size_t busy{0};
+    size_t expanded{0};
+    bool done{false};
+    NodePtr solution;
+
+    pool.parallel_for(pool.size(), [&](size_t) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            // wait for work, unless nobody is expanding anything that could still produce some
+            if (!changed.wait_until(lock, deadline, [&] { return done || !open.empty() || busy == 0; })) {
+                done = true;
+            }
+            if (done || open.empty() || Clock::now() > deadline) {
+                done = true;
+                changed.notify_all();
+                return;
+            }
+
+            const auto node = open.pop();
+            if (node->conflicts == 0) {
+                solution = node;
+                done = true;
+                changed.notify_all();
+                return;
+            }
+            ++busy;
+            ++expanded;
+            lock.unlock();
+
+            const auto &c = node->conflict;
+            NodePtr children[2];
+            const bool found_1 = make_child(problem, *node, c.robot_1, c.point_1, c.robot_2, c.point_2,
+                                            children[0]);
+            const bool found_2 = make_child(problem, *node, c.robot_2, c.point_2, c.robot_1, c.point_1,
+                                            children[1]);
+
+            lock.lock();
+            if (found_1) {
+                open.push(std::move(children[0]));
+            }
+            if (found_2) {
+                open.push(std::move(children[1]));
+            }
+            --busy;
+            changed.notify_all();
+        }
+    });
+
+    if (!solution) {
+        std::cout << "CBS: no conflict free solution found after expanding " << expanded << " nodes\n";
+        return false;
+    }
+    std::cout << "CBS: solution found after expanding " << expanded << " nodes\n";
+
+    move_strings.clear();
+    for (size_t r{0}; r < problem.robots.size(); ++r) {
+        std::string move_string;
+        const auto &route = *solution->routes[r];
+        for (const auto &plan : route.plans) {
+            move_string += delivery_to_string(plan);
+        }
+        route.to_home.append_actions(move_string);
+        // parked robots wait for the others to finish
+        move_string.resize(static_cast<size_t>(solution->makespan), 'S');
+        move_strings.emplace_back(problem.robots[r].id, std::move(move_string));
+    }
+    return true;
+}
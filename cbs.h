@@ -0,0 +1,24 @@
+#ifndef MAPF_CBS_H
+#define MAPF_CBS_H
+
+#include "input_parsing.h"
+#include "options.h"
+#include "solver.h"
+
+class DistanceTable;
+class ThreadPool;
+
+/*
+ * Conflict based search. Every robot gets its deliveries from the allocation up front and plans them as one route
+ * without looking at the others. The first conflict between two routes is resolved by branching: in one child the
+ * first robot has to avoid the point of the second, in the other child the other way around, and only the constrained
+ * robot is replanned. Constraints cover the whole time the other robot stays on the field. The constraint tree is
+ * searched best first (makespan, then summed route lengths) by all threads of pool, with options.suboptimality > 1 as
+ * a focal search preferring nodes with fewer conflicts (ECBS). Robots stay on their last field once their route is
+ * done, unless they are in the way there, then they return to their start field.
+ * @return false if no conflict free solution was found within options.time_limit, the reason has been printed already
+ */
+bool solve_cbs(const Instance &inst, const DistanceTable &distances, const Options &options, ThreadPool &pool,
+               MoveStrings &move_strings);
+
+#endif //MAPF_CBS_H
@@ -0,0 +1,156 @@
+#include "compact_path.h"
+
+CompactPath::Iterator::Iterator(const CompactPath &path, size_t index, SpaceTimePoint p) noexcept
+        : m_path(&path), m_index{index}, m_p(p) {}
+
+CompactPath::Iterator &CompactPath::Iterator::operator++() noexcept {
+    if (++m_index < m_path->size()) {
+        m_p = apply_move(m_p, m_path->move(m_index - 1));
+    }
+    return *this;
+}
+
+CompactPath::Iterator CompactPath::Iterator::operator++(int) noexcept {
+    auto before = *this;
+    ++*this;
+    return before;
+}
+
+CompactPath::CompactPath(SpaceTimePoint start) : m_front(start), m_back(start), m_size{1} {}
+
+CompactPath::CompactPath(SpaceTimePoint start, size_t moves) : CompactPath(start) {
+    m_words.reserve((moves + moves_per_word - 1) / moves_per_word);
+    for (size_t k{0}; k < moves; ++k) {
+        push_back(Move::Rest);
+    }
+}
+
+CompactPath::CompactPath(const std::vector<SpaceTimePoint> &points) {
+    m_words.reserve((points.size() + moves_per_word - 1) / moves_per_word);
+    for (const auto p : points) {
+        push_back(p);
+    }
+}
+
+void CompactPath::push_back(Move move) {
+    const auto k = m_size - 1;
+    if (k % moves_per_word == 0) {
+        m_words.push_back(0);
+    }
+    m_words.back() |= static_cast<uint64_t>(move) << (3u * (k % moves_per_word));
+    m_back = apply_move(m_back, move);
+    ++m_size;
+}
+
+void CompactPath::push_back(SpaceTimePoint p) {
+    if (empty()) {
+        *this = CompactPath(p);
+    } else {
+        push_back(move_between(m_back, p));
+    }
+}
+
+void CompactPath::set_move(size_t k, Move move) {
+    const auto old = this->move(k);
+    auto &word = m_words[k / moves_per_word];
+    const auto shift = 3u * (k % moves_per_word);
+    word = (word & ~(move_mask << shift)) | (static_cast<uint64_t>(move) << shift);
+
+    // take the old move back, then do the new one
+    const auto undone = apply_move(SpaceTimePoint(), old);
+    const auto done = apply_move(SpaceTimePoint(), move);
+    m_back.x += done.x - undone.x;
+    m_back.y += done.y - undone.y;
+}
+
+Move CompactPath::move(size_t k) const noexcept {
+    return static_cast<Move>((m_words[k / moves_per_word] >> (3u * (k % moves_per_word))) & move_mask);
+}
+
+void CompactPath::clear() noexcept {
+    m_size = 0;
+    m_words.clear();
+}
+
+bool CompactPath::empty() const noexcept {
+    return m_size == 0;
+}
+
+size_t CompactPath::size() const noexcept {
+    return m_size;
+}
+
+size_t CompactPath::moves() const noexcept {
+    return m_size == 0 ? 0 : m_size - 1;
+}
+
+SpaceTimePoint CompactPath::front() const noexcept {
+    return m_front;
+}
+
+SpaceTimePoint CompactPath::back() const noexcept {
+    return m_back;
+}
+
+CompactPath::Iterator CompactPath::begin() const noexcept {
+    return Iterator(*this, 0, m_front);
+}
+
+CompactPath::Iterator CompactPath::end() const noexcept {
+    return Iterator(*this, m_size, m_back);
+}
+
+void CompactPath::append_actions(std::string &actions) const {
+    for (size_t k{0}; k < moves(); ++k) {
+        actions.push_back(move_to_char(move(k)));
+    }
+}
+
+SpaceTimePoint apply_move(SpaceTimePoint p, Move move) noexcept {
+    switch (move) {
+        case Move::Up:
+            return SpaceTimePoint(p.x, p.y - 1, p.t + 1);
+        case Move::Down:
+            return SpaceTimePoint(p.x, p.y + 1, p.t + 1);
+        case Move::Left:
+            return SpaceTimePoint(p.x - 1, p.y, p.t + 1);
+        case Move::Right:
+            return SpaceTimePoint(p.x + 1, p.y, p.t + 1);
+        case Move::Rest:
+            break;
+    }
+    return SpaceTimePoint(p.x, p.y, p.t + 1);
+}
+
+Move move_between(SpaceTimePoint p, SpaceTimePoint next) noexcept {
+    if (p.x < next.x) {
+        return Move::Right;
+    } else if (p.x > next.x) {
+        return Move::Left;
+    } else if (p.y < next.y) {
+        return Move::Down;
+    } else if (p.y > next.y) {
+        return Move::Up;
+    }
+    return Move::Rest;
+}
+
+char move_to_char(Move move) noexcept {
+    switch (move) {
+        case Move::Up:
+            return 'U';
+        case Move::Down:
+            return 'D';
+        case Move::Left:
+            return 'L';
+        case Move::Right:
+            return 'R';
+        case Move::Rest:
+            break;
+    }
+    return 'S';
+}
+
+bool is_move_char(char c) noexcept {
+    return c == 'U' || c == 'D' || c == 'L' || c == 'R' || c == 'S';
+}
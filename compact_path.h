@@ -0,0 +1,134 @@
+#ifndef MAPF_COMPACT_PATH_H
+#define MAPF_COMPACT_PATH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "pathfinding.h"
+
+/* A path of a single robot, one point per time step, stored as its first point and one Move per step packed into 3
+ * bits (21 moves per word), about 30 times less than a SpaceTimePoint per step. The points are computed while
+ * iterating, only the first and the last one are kept as such.
+ */
+class CompactPath {
+public:
+    /* Forward iterator over the points of a path, they are computed on the fly so the value is a copy.
+     */
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = SpaceTimePoint;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const SpaceTimePoint *;
+        using reference = const SpaceTimePoint &;
+
+        Iterator(const CompactPath &path, size_t index, SpaceTimePoint p) noexcept;
+
+        reference operator*() const noexcept { return m_p; }
+
+        pointer operator->() const noexcept { return &m_p; }
+
+        Iterator &operator++() noexcept;
+
+        Iterator operator++(int) noexcept;
+
+        bool operator==(const Iterator &other) const noexcept { return m_index == other.m_index; }
+
+        bool operator!=(const Iterator &other) const noexcept { return m_index != other.m_index; }
+
+    private:
+        const CompactPath *m_path;
+        size_t m_index;
+        SpaceTimePoint m_p;
+    };
+
+    /*
+     * A path without any point
+     */
+    CompactPath() = default;
+
+    explicit CompactPath(SpaceTimePoint start);
+
+    /*
+     * A path resting on start for moves steps, see set_move
+     */
+    CompactPath(SpaceTimePoint start, size_t moves);
+
+    /*
+     * Converts a list of points, each one step after and at most one field away from the one before
+     */
+    explicit CompactPath(const std::vector<SpaceTimePoint> &points);
+
+    /*
+     * Adds a step at the end, the path must not be empty
+     */
+    void push_back(Move move);
+
+    /*
+     * Adds p at the end, it has to be one step after and at most one field away from back(). If the path is empty p
+     * becomes its first point.
+     */
+    void push_back(SpaceTimePoint p);
+
+    /*
+     * Replaces the k-th step, all later points move along
+     */
+    void set_move(size_t k, Move move);
+
+    Move move(size_t k) const noexcept;
+
+    void clear() noexcept;
+
+    bool empty() const noexcept;
+
+    /*
+     * @return number of points, one more than the number of moves unless empty
+     */
+    size_t size() const noexcept;
+
+    size_t moves() const noexcept;
+
+    SpaceTimePoint front() const noexcept;
+
+    SpaceTimePoint back() const noexcept;
+
+    Iterator begin() const noexcept;
+
+    Iterator end() const noexcept;
+
+    /*
+     * Appends the output char of every move, U, D, L, R or S
+     */
+    void append_actions(std::string &actions) const;
+
+private:
+    static constexpr size_t moves_per_word{21};
+    static constexpr uint64_t move_mask{7u};
+
+    SpaceTimePoint m_front;
+    SpaceTimePoint m_back;
+    size_t m_size{0};
+    std::vector<uint64_t> m_words;
+};
+
+/*
+ * @return p one step later after move
+ */
+SpaceTimePoint apply_move(SpaceTimePoint p, Move move) noexcept;
+
+/*
+ * @return the move from p to the neighbouring field next
+ */
+Move move_between(SpaceTimePoint p, SpaceTimePoint next) noexcept;
+
+char move_to_char(Move move) noexcept;
+
+/*
+ * @return true iff c is the char of a move or of staying, see move_to_char
+ */
+bool is_move_char(char c) noexcept;
+
+#endif //MAPF_COMPACT_PATH_H
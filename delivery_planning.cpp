@@ -0,0 +1,181 @@
+#include "delivery_planning.h"
+
+#include <algorithm>
+
+#include "distance_table.h"
+#include "reservation_table.h"
+
+DeliveryTask make_delivery_task(const Delivery &d, const Instance &inst, const DistanceTable &distances) {
+    const auto &grid = *distances.grid();
+    const auto delivery_start = grid.shelf_position(d.start);
+    const auto delivery_goal = grid.shelf_position(d.goal);
+
+    if (inst.charger_positions.empty()) {
+        // nothing to recharge at, plan_delivery fails and the estimates only see the way between the shelves
+        return DeliveryTask{d, delivery_start, delivery_goal, delivery_goal, delivery_goal, {}};
+    }
+    // Go to a charger between the two shelves to recharge the robot
+    const auto charger_1 = *std::min_element(inst.charger_positions.begin(), inst.charger_positions.end(),
+                                             [&](const SpacePoint p1, const SpacePoint p2) {
+                                                 const auto d1 = distances.distance(p1, delivery_start) +
+                                                                 distances.distance(p1, delivery_goal);
+                                                 const auto d2 = distances.distance(p2, delivery_start) +
+                                                                 distances.distance(p2, delivery_goal);
+                                                 return d1 < d2;
+                                             });
+    // find the closest charger to our goal and move there to recharge
+    const auto charger_2 = *std::min_element(inst.charger_positions.begin(), inst.charger_positions.end(),
+                                             [&](const SpacePoint p1, const SpacePoint p2) {
+                                                 return distances.distance(p1, delivery_goal) <
+                                                        distances.distance(p2, delivery_goal);
+                                             });
+    std::vector<int32_t> charger_1_tails;
+    for (const auto c : inst.charger_positions) {
+        const auto to_goal = distances.distance(delivery_goal, c);
+        charger_1_tails.push_back(to_goal == DistanceTable::unreachable ? -1 : to_goal);
+    }
+    return DeliveryTask{d, delivery_start, delivery_goal, charger_1, charger_2, charger_1_tails};
+}
+
+int32_t delivery_lower_bound(const RobotState &robot, const DeliveryTask &task, const Instance &inst,
+                             const DistanceTable &distances) {
+    const auto to_start = distances.distance(task.start, SpacePoint(robot.endpoint));
+    if (to_start == DistanceTable::unreachable || to_start > robot.charge) {
+        return -1;
+    }
+    int32_t bound{-1};
+    for (size_t k{0}; k < inst.charger_positions.size(); ++k) {
+        const auto to_charger = distances.distance(inst.charger_positions[k], task.start);
+        const auto to_goal = task.charger_1_tails[k];
+        if (to_charger == DistanceTable::unreachable || to_start + to_charger > robot.charge || to_goal < 0
+            || to_goal > inst.charge) {
+            continue;
+        }
+        // at the charger the robot waits until it has got back all charge it is missing by then
+        const auto recharge = inst.charge - (robot.charge - to_start - to_charger);
+        const auto end = robot.endpoint.t + to_start + 1 + to_charger + recharge + to_goal + 1;
+        if (bound < 0 || end < bound) {
+            bound = end;
+        }
+    }
+    return bound;
+}
+
+bool plan_delivery(const RobotState &robot, const DeliveryTask &task, const Instance &inst,
+                   const DistanceTable &distances, const ReservationTable &reservations, PathPlanner plan_path,
+                   SearchContext &context, DeliveryPlan &plan) {
+    const auto robot_start = robot.endpoint;
+    auto charge = robot.charge;
+    plan.robot_id = robot.id;
+    plan.delivery_id = task.delivery.id;
+
+    // path robot_start - start
+    plan.to_start = plan_path(robot_start, task.start, 1, charge, inst.width, inst.height, reservations,
+                              &distances, context);
+    charge = charge - get_used_charge(plan.to_start);
+    if (charge < 0 || plan.to_start.empty()) { return false; }
+
+    // rest for a moment to load the package
+    const SpaceTimePoint delivery_start_timed(plan.to_start.back().x, plan.to_start.back().y,
+                                              plan.to_start.back().t + 1);
+
+    // the charger between the shelves that gets us to the goal shelf first, and has room for recharging
+    plan.to_charge_1 = a_star_to_charger(delivery_start_timed, charge, inst.charge, task.charger_1_tails,
+                                         reservations, distances, context);
+    charge = charge - get_used_charge(plan.to_charge_1);
+    if (charge < 0 || plan.to_charge_1.empty()) { return false; }
+
+    // check how long we want to stay at the charger
+    plan.rest_period_1 = inst.charge - charge;
+    const SpaceTimePoint charger_after_recharge(plan.to_charge_1.back().x, plan.to_charge_1.back().y,
+                                                plan.to_charge_1.back().t + plan.rest_period_1);
+    charge = inst.charge; // recharge happened
+
+    // path start - goal
+    plan.to_goal = plan_path(charger_after_recharge, task.goal, 1, charge, inst.width, inst.height, reservations,
+                             &distances, context);
+    charge = charge - get_used_charge(plan.to_goal);
+    if (charge < 0 || plan.to_goal.empty()) { return false; }
+
+    // rest for a moment to unload
+    const SpaceTimePoint after_delivery(plan.to_goal.back().x, plan.to_goal.back().y, plan.to_goal.back().t + 1);
+
+    plan.to_charge_2 = a_star_to_charger(after_delivery, charge, inst.charge, {}, reservations, distances, context);
+    charge = charge - get_used_charge(plan.to_charge_2);
+    if (charge < 0) { return false; }
+
+    plan.rest_period_2 = 0;
+    if (!plan.to_charge_2.empty()) {
+        plan.rest_period_2 = inst.charge - charge;
+        plan.endpoint = SpaceTimePoint(plan.to_charge_2.back().x, plan.to_charge_2.back().y,
+                                       plan.to_charge_2.back().t + plan.rest_period_2);
+        charge = inst.charge;
+    } else {
+        // No path to a charger, no recharging
+        plan.endpoint = SpaceTimePoint(plan.to_goal.back().x, plan.to_goal.back().y, plan.to_goal.back().t + 1);
+    }
+    plan.charge = charge;
+    return true;
+}
+
+bool plan_route(const RobotState &robot, const std::vector<const DeliveryTask *> &tasks, const Instance &inst,
+                const DistanceTable &distances, const ReservationTable &reservations, PathPlanner plan_path,
+                SearchContext &context, std::vector<DeliveryPlan> &plans) {
+    plans.resize(tasks.size());
+    auto state = robot;
+    for (size_t k{0}; k < tasks.size(); ++k) {
+        if (!plan_delivery(state, *tasks[k], inst, distances, reservations, plan_path, context, plans[k])) {
+            return false;
+        }
+        state.charge = plans[k].charge;
+        state.endpoint = plans[k].endpoint;
+    }
+    return true;
+}
+
+void reserve_delivery(const DeliveryPlan &plan, ReservationTable &reservations) {
+    // insert rests for the first rest period into reservations
+    for (int32_t k{1}; k <= plan.rest_period_1; ++k) {
+        const auto x = plan.to_charge_1.back().x;
+        const auto y = plan.to_charge_1.back().y;
+        const auto t = plan.to_charge_1.back().t + k;
+        reservations.reserve(SpaceTimePoint(x, y, t));
+    }
+    // insert rests for the second rest period into reservations
+    if (!plan.to_charge_2.empty()) {
+        for (int32_t k{1}; k <= plan.rest_period_2; ++k) {
+            const auto x = plan.to_charge_2.back().x;
+            const auto y = plan.to_charge_2.back().y;
+            const auto t = plan.to_charge_2.back().t + k;
+            reservations.reserve(SpaceTimePoint(x, y, t));
+        }
+    }
+    for (const auto p : plan.to_start) {
+        reservations.reserve(p);
+    }
+    for (const auto p : plan.to_charge_1) {
+        reservations.reserve(p);
+    }
+    for (const auto p : plan.to_goal) {
+        reservations.reserve(p);
+    }
+    for (const auto p : plan.to_charge_2) {
+        reservations.reserve(p);
+    }
+    reservations.reserve(plan.endpoint);
+}
+
+std::string delivery_to_string(const DeliveryPlan &plan) {
+    std::string move_string;
+    plan.to_start.append_actions(move_string);
+    move_string.push_back(plan.delivery_id); // staying for loading
+    plan.to_charge_1.append_actions(move_string);
+    move_string.append(static_cast<size_t>(std::max(plan.rest_period_1, 0)), 'S');
+    plan.to_goal.append_actions(move_string);
+    move_string.push_back(plan.delivery_id); // staying for unloading
+    if (!plan.to_charge_2.empty()) {
+        plan.to_charge_2.append_actions(move_string);
+        move_string.append(static_cast<size_t>(std::max(plan.rest_period_2, 0)), 'S');
+    }
+    return move_string;
+}
@@ -0,0 +1,91 @@
+#ifndef MAPF_DELIVERY_PLANNING_H
+#define MAPF_DELIVERY_PLANNING_H
+
+#include <string>
+#include <vector>
+
+#include "compact_path.h"
+#include "input_parsing.h"
+#include "pathfinding.h"
+
+class DistanceTable;
+
+/* Where a robot will be once it has done all work assigned so far, and the charge it has left then.
+ */
+struct RobotState {
+    int32_t id;
+    int32_t charge;
+    SpaceTimePoint endpoint;
+};
+
+/* Everything a robot does for one delivery: go to the start shelf, load, go to a charger and recharge, go to the goal
+ * shelf, unload, go to a charger and recharge again.
+ */
+struct DeliveryPlan {
+    int32_t robot_id;
+    char delivery_id;
+    CompactPath to_start;
+    CompactPath to_charge_1;
+    CompactPath to_goal;
+    CompactPath to_charge_2; // may be empty if no charger could be reached after unloading
+    int32_t rest_period_1;
+    int32_t rest_period_2;
+    int32_t charge; // charge after the delivery
+    SpaceTimePoint endpoint;
+};
+
+/* Read only data needed to plan a delivery, shared by all candidate robots.
+ */
+struct DeliveryTask {
+    Delivery delivery;
+    SpacePoint start;
+    SpacePoint goal;
+    SpacePoint charger_1; // charger expected between loading and unloading, for estimates
+    SpacePoint charger_2; // charger expected after unloading, for estimates
+    std::vector<int32_t> charger_1_tails; // per charger the distance on to the goal shelf, -1 if unreachable
+};
+
+/*
+ * Looks up the shelves of d and picks the chargers to expect, closest by true distance. When planning, the charger
+ * that is done first given the reservations is searched instead. Without chargers both are the goal shelf, and
+ * plan_delivery fails for every robot.
+ */
+DeliveryTask make_delivery_task(const Delivery &d, const Instance &inst, const DistanceTable &distances);
+
+/*
+ * Lower bound on the endpoint time of plan_delivery for robot from the distances alone: the moves to the start shelf,
+ * loading, the moves via the best charger to the goal shelf, the recharge the moves so far force and unloading.
+ * Chargers the robot can't reach with its charge, or that are too far from the goal shelf for a full one, don't count.
+ * @return -1 if the robot can't make the delivery whatever the reservations are
+ */
+int32_t delivery_lower_bound(const RobotState &robot, const DeliveryTask &task, const Instance &inst,
+                             const DistanceTable &distances);
+
+/*
+ * Plans all legs of task for robot without touching the reservations, so this can be run for several robots at once.
+ * @return true iff all legs were found, plan is only valid then
+ */
+bool plan_delivery(const RobotState &robot, const DeliveryTask &task, const Instance &inst,
+                   const DistanceTable &distances, const ReservationTable &reservations, PathPlanner plan_path,
+                   SearchContext &context, DeliveryPlan &plan);
+
+/*
+ * Plans the deliveries of tasks one after another for robot, each starting where the previous one ended.
+ * Like plan_delivery the reservations are only read, the robot's own earlier deliveries are not in the way.
+ * @return true iff every delivery could be planned, plans then holds one plan per task
+ */
+bool plan_route(const RobotState &robot, const std::vector<const DeliveryTask *> &tasks, const Instance &inst,
+                const DistanceTable &distances, const ReservationTable &reservations, PathPlanner plan_path,
+                SearchContext &context, std::vector<DeliveryPlan> &plans);
+
+/*
+ * Inserts all points of plan (including the rest periods) into the reservations.
+ */
+void reserve_delivery(const DeliveryPlan &plan, ReservationTable &reservations);
+
+/*
+ * @return the actions of plan in the output alphabet, the package id marks loading and unloading
+ */
+std::string delivery_to_string(const DeliveryPlan &plan);
+
+#endif //MAPF_DELIVERY_PLANNING_H
@@ -0,0 +1,220 @@
+#include "distance_table.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <numeric>
+
+#include "hpa.h"
+#include "layout_cache.h"
+
+struct DistanceTable::LazyClusters {
+    std::once_flag built;
+    std::unique_ptr<const ClusterGraph> graph;
+    // where the graph is cached, empty path if it isn't
+    LayoutHeader header{};
+    std::string layout;
+    std::string path;
+};
+
+DistanceTable::DistanceTable(const Instance &inst) : DistanceTable(inst, std::string{}) {}
+
+DistanceTable::DistanceTable(const Instance &inst, const std::string &cache_dir, size_t field_memory)
+        : m_grid(std::make_shared<const Grid>(inst)), m_width{inst.width}, m_height{inst.height},
+          m_fields{nullptr}, m_charger_field{nullptr}, m_chargers(inst.charger_positions),
+          m_clusters(std::make_shared<LazyClusters>()) {
+    const auto cells = static_cast<size_t>(m_width) * static_cast<size_t>(m_height);
+    m_field_of_cell.assign(cells, -1);
+    m_charger_of_cell.assign(cells, -1);
+    for (size_t k{0}; k < inst.charger_positions.size(); ++k) {
+        m_charger_of_cell[index(inst.charger_positions[k])] = static_cast<int32_t>(k);
+    }
+
+    // the chargers are part of every delivery, the shelves only of the deliveries starting or ending there
+    std::vector<SpacePoint> targets(inst.charger_positions);
+    std::vector<size_t> shelf_order(inst.shelf_positions.size());
+    std::vector<size_t> deliveries_at(inst.shelf_positions.size(), 0);
+    for (const auto &d : inst.deliveries) {
+        ++deliveries_at[static_cast<size_t>(d.start)];
+        ++deliveries_at[static_cast<size_t>(d.goal)];
+    }
+    std::iota(shelf_order.begin(), shelf_order.end(), size_t{0});
+    std::stable_sort(shelf_order.begin(), shelf_order.end(), [&deliveries_at](size_t s1, size_t s2) {
+        return deliveries_at[s1] > deliveries_at[s2];
+    });
+    for (const auto s : shelf_order) {
+        targets.push_back(inst.shelf_positions[s].second);
+    }
+
+    const auto charger_fields = inst.charger_positions.empty() ? size_t{0} : size_t{1};
+    const auto field_bytes = std::max(cells * sizeof(uint16_t), size_t{1});
+    const auto fitting = std::max(field_memory / field_bytes, charger_fields) - charger_fields;
+    // the cells of the targets with a field, in field order, they are stored in front of the cached fields
+    std::vector<uint32_t> field_cells;
+    for (const auto t : targets) {
+        if (field_cells.size() == fitting) {
+            break;
+        }
+        if (m_field_of_cell[index(t)] < 0) {
+            m_field_of_cell[index(t)] = static_cast<int32_t>(field_cells.size());
+            field_cells.push_back(static_cast<uint32_t>(index(t)));
+        }
+    }
+    const auto fields = field_cells.size();
+    const auto stored = fields + charger_fields;
+    const auto set_fields = [&](const uint16_t *data) {
+        m_fields = data;
+        m_charger_field = charger_fields == 0 ? nullptr : data + fields * cells;
+    };
+
+    // padded to 8 bytes, so the fields following it stay aligned
+    field_cells.resize((fields + 1) / 2 * 2, 0);
+    const auto cells_bytes = field_cells.size() * sizeof(uint32_t);
+    const auto bytes = stored * cells * sizeof(uint16_t);
+    const auto header = make_layout_header(inst, LayoutData::DistanceFields, static_cast<uint32_t>(stored));
+    const auto path = cache_dir.empty() ? std::string{} : layout_path(cache_dir, header);
+    if (!cache_dir.empty()) {
+        m_clusters->header = make_layout_header(inst, LayoutData::ClusterGraph, ClusterGraph::default_cluster_size);
+        m_clusters->layout = layout_contents(inst);
+        m_clusters->path = layout_path(cache_dir, m_clusters->header);
+        auto file = map_layout(path, header, m_clusters->layout);
+        // the targets that got a field depend on the deliveries as well, not only on the layout
+        if (file && layout_data(*file).size() == cells_bytes + bytes
+            && std::memcmp(layout_data(*file).data(), field_cells.data(), cells_bytes) == 0) {
+            set_fields(reinterpret_cast<const uint16_t *>(layout_data(*file).data() + cells_bytes));
+            m_storage = std::move(file);
+            return;
+        }
+    }
+
+    auto buffer = std::make_shared<std::vector<uint16_t>>(stored * cells, unreachable);
+    for (size_t f{0}; f < fields; ++f) {
+        const auto c = static_cast<int32_t>(field_cells[f]);
+        bfs({SpacePoint(c % m_width, c / m_width)}, buffer->data() + f * cells);
+    }
+    if (!inst.charger_positions.empty()) {
+        bfs(inst.charger_positions, buffer->data() + fields * cells);
+    }
+    set_fields(buffer->data());
+    m_storage = std::move(buffer);
+    if (!path.empty()) {
+        std::string data(reinterpret_cast<const char *>(field_cells.data()), cells_bytes);
+        data.append(reinterpret_cast<const char *>(m_fields), bytes);
+        write_layout(path, header, m_clusters->layout, data);
+    }
+}
+
+bool DistanceTable::has_field(SpacePoint target) const {
+    return field(target) != nullptr;
+}
+
+uint16_t DistanceTable::distance(SpacePoint target, SpacePoint p) const {
+    const auto f = field(target);
+    if (!f) {
+        return static_cast<uint16_t>(std::min<uint32_t>(manhatten_distance(target, p), unreachable - 1));
+    }
+    return f[index(p)];
+}
+
+const uint16_t *DistanceTable::field(SpacePoint target) const {
+    if (target.x < 0 || target.y < 0 || target.x >= m_width || target.y >= m_height) {
+        return nullptr;
+    }
+    const auto f = m_field_of_cell[index(target)];
+    if (f < 0) {
+        return nullptr;
+    }
+    return m_fields + static_cast<size_t>(f) * m_field_of_cell.size();
+}
+
+const uint16_t *DistanceTable::charger_field() const {
+    return m_charger_field;
+}
+
+const std::vector<SpacePoint> &DistanceTable::chargers() const noexcept {
+    return m_chargers;
+}
+
+int32_t DistanceTable::charger_index(SpacePoint p) const {
+    if (p.x < 0 || p.y < 0 || p.x >= m_width || p.y >= m_height) {
+        return -1;
+    }
+    return m_charger_of_cell[index(p)];
+}
+
+const ClusterGraph &DistanceTable::clusters() const {
+    std::call_once(m_clusters->built, [this]() {
+        auto &lazy = *m_clusters;
+        const auto cluster_size = ClusterGraph::default_cluster_size;
+        if (!lazy.path.empty()) {
+            if (auto file = map_layout(lazy.path, lazy.header, lazy.layout)) {
+                const auto data = layout_data(*file);
+                lazy.graph = ClusterGraph::from_data(m_grid, cluster_size, data, std::move(file));
+            }
+        }
+        if (!lazy.graph) {
+            lazy.graph = std::make_unique<const ClusterGraph>(m_grid, cluster_size);
+            if (!lazy.path.empty()) {
+                write_layout(lazy.path, lazy.header, lazy.layout, lazy.graph->data());
+            }
+        }
+    });
+    return *m_clusters->graph;
+}
+
+const std::shared_ptr<const Grid> &DistanceTable::grid() const noexcept {
+    return m_grid;
+}
+
+int32_t DistanceTable::width() const noexcept {
+    return m_width;
+}
+
+int32_t DistanceTable::height() const noexcept {
+    return m_height;
+}
+
+size_t DistanceTable::index(SpacePoint p) const noexcept {
+    return static_cast<size_t>(p.y) * static_cast<size_t>(m_width) + static_cast<size_t>(p.x);
+}
+
+void DistanceTable::bfs(const std::vector<SpacePoint> &targets, uint16_t *field) const {
+    // plain BFS with the queue as a vector, every cell is enqueued at most once
+    std::vector<SpacePoint> queue;
+    queue.reserve(m_grid->cells());
+    for (const auto target : targets) {
+        if (field[index(target)] != 0) {
+            field[index(target)] = 0;
+            queue.push_back(target);
+        }
+    }
+
+    for (size_t head{0}; head < queue.size(); ++head) {
+        const auto p = queue[head];
+        const auto d = field[index(p)];
+        // saturate instead of overflowing, an underestimation is still a valid heuristic
+        const uint16_t next = d >= unreachable - 1 ? unreachable - 1 : d + 1;
+
+        const auto visit = [&](int32_t x, int32_t y) {
+            const auto i = index(SpacePoint(x, y));
+            if (field[i] == unreachable) {
+                field[i] = next;
+                queue.emplace_back(x, y);
+            }
+        };
+        // the mask only has neighbours inside the grid that aren't walls
+        const auto mask = m_grid->neighbours(p.x, p.y);
+        if (mask & Grid::left) {
+            visit(p.x - 1, p.y);
+        }
+        if (mask & Grid::right) {
+            visit(p.x + 1, p.y);
+        }
+        if (mask & Grid::up) {
+            visit(p.x, p.y - 1);
+        }
+        if (mask & Grid::down) {
+            visit(p.x, p.y + 1);
+        }
+    }
+}
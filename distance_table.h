@@ -0,0 +1,110 @@
+#ifndef MAPF_DISTANCE_TABLE_H
+#define MAPF_DISTANCE_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "grid.h"
+#include "input_parsing.h"
+
+class ClusterGraph;
+
+/* Exact (walls respected, other robots ignored) distances to the shelves and chargers of an instance.
+ * The grid never changes while solving, so one BFS per target at startup is enough, or none at all when the layout
+ * cache has the fields already. Each field is a flat width * height array of uint16_t, distances that don't fit are
+ * saturated, which keeps them admissible.
+ * One more field holds the distance to the nearest charger, for searches towards all chargers at once.
+ *
+ * A field takes 2 bytes per cell, so on large grids only as many fields are computed as fit into the field memory
+ * given. The nearest charger field is always kept, then the chargers, then the shelves the most deliveries start or
+ * end at. Targets without a field fall back to the manhattan distance, which is admissible as well.
+ *
+ * The compiled grid of the instance is built here as well and shared with everyone who needs the static map.
+ */
+class DistanceTable {
+public:
+    static constexpr uint16_t unreachable = 0xFFFFu;
+
+    // bytes the fields may take by default, 128 fields of a 1024 x 1024 grid
+    static constexpr size_t default_field_memory = size_t{256} << 20u;
+
+    explicit DistanceTable(const Instance &inst);
+
+    /*
+     * Like above, but the fields are mapped from the layout cache in cache_dir if it has the layout of inst already,
+     * otherwise they are computed and written there for the next run, see layout_cache.h. An empty cache_dir means
+     * no cache.
+     * @param field_memory bytes all fields together may take, the nearest charger field is kept in any case
+     */
+    DistanceTable(const Instance &inst, const std::string &cache_dir, size_t field_memory = default_field_memory);
+
+    /*
+     * @return true iff a distance field towards target has been computed
+     */
+    bool has_field(SpacePoint target) const;
+
+    /*
+     * Distance from p to target, the manhattan distance if there is no field towards target, see has_field.
+     * @return the number of moves needed (at least) or unreachable
+     */
+    uint16_t distance(SpacePoint target, SpacePoint p) const;
+
+    /*
+     * @return the distance field towards target or nullptr if there is none
+     */
+    const uint16_t *field(SpacePoint target) const;
+
+    /*
+     * @return the distance field towards the nearest charger or nullptr if the instance has no chargers
+     */
+    const uint16_t *charger_field() const;
+
+    /*
+     * @return the chargers of the instance, in the order of inst.charger_positions
+     */
+    const std::vector<SpacePoint> &chargers() const noexcept;
+
+    /*
+     * @return the index of the charger at p in inst.charger_positions, -1 if there is none
+     */
+    int32_t charger_index(SpacePoint p) const;
+
+    /*
+     * @return the abstract graph of the grid for hierarchical planning, built by the first call of any thread
+     */
+    const ClusterGraph &clusters() const;
+
+    /*
+     * @return the compiled grid of the instance, reservation tables of the instance are built on it
+     */
+    const std::shared_ptr<const Grid> &grid() const noexcept;
+
+    int32_t width() const noexcept;
+
+    int32_t height() const noexcept;
+
+private:
+    size_t index(SpacePoint p) const noexcept;
+
+    void bfs(const std::vector<SpacePoint> &targets, uint16_t *field) const;
+
+    std::shared_ptr<const Grid> m_grid;
+    int32_t m_width;
+    int32_t m_height;
+    std::vector<int32_t> m_field_of_cell;
+    // The fields of all targets one after another, then the nearest charger field if there are chargers. They live in
+    // m_storage, a buffer of their own or a mapped layout file, which the copies of the table share.
+    std::shared_ptr<const void> m_storage;
+    const uint16_t *m_fields;
+    const uint16_t *m_charger_field; // nullptr if there are no chargers
+    std::vector<SpacePoint> m_chargers;
+    std::vector<int32_t> m_charger_of_cell;
+    // only the hierarchical planner needs it, so it is built on demand, shared by the copies of the table
+    struct LazyClusters;
+    std::shared_ptr<LazyClusters> m_clusters;
+};
+
+#endif //MAPF_DISTANCE_TABLE_H
@@ -0,0 +1,121 @@
+#include "grid.h"
+
+#include <algorithm>
+#include <climits>
+
+Grid::Grid(int32_t width, int32_t height)
+        : m_width{width}, m_height{height}, m_types(static_cast<size_t>(width) * static_cast<size_t>(height), 0),
+          m_min_robot_id{0} {
+    compute_neighbours();
+}
+
+Grid::Grid(const Instance &inst) : Grid(inst.width, inst.height) {
+    for (const auto w : inst.wall_positions) {
+        set_type(w, wall);
+    }
+    for (const auto &s : inst.shelf_positions) {
+        set_type(s.second, shelf);
+        m_shelves.push_back(s.second);
+    }
+    for (const auto c : inst.charger_positions) {
+        set_type(c, charger);
+    }
+
+    int32_t max_id{0};
+    for (size_t k{0}; k < inst.robot_positions.size(); ++k) {
+        const auto &r = inst.robot_positions[k];
+        set_type(r.second, robot_start);
+        m_robots.push_back(r.second);
+        m_sorted_robot_ids.emplace_back(r.first, static_cast<int32_t>(k));
+        m_min_robot_id = k == 0 ? r.first : std::min(m_min_robot_id, r.first);
+        max_id = k == 0 ? r.first : std::max(max_id, r.first);
+    }
+    std::sort(m_sorted_robot_ids.begin(), m_sorted_robot_ids.end());
+
+    // ids are dense in practice (0-9 in the original format), then a plain table indexed by id does, otherwise the
+    // sorted ids are searched
+    const auto span = int64_t{max_id} - m_min_robot_id + 1;
+    if (!m_robots.empty() && span <= 4 * static_cast<int64_t>(m_robots.size()) + 1024) {
+        m_robot_index.assign(static_cast<size_t>(span), -1);
+        for (const auto &r : m_sorted_robot_ids) {
+            m_robot_index[static_cast<size_t>(r.first - m_min_robot_id)] = r.second;
+        }
+    }
+    compute_neighbours();
+}
+
+int32_t Grid::width() const noexcept {
+    return m_width;
+}
+
+int32_t Grid::height() const noexcept {
+    return m_height;
+}
+
+size_t Grid::cells() const noexcept {
+    return m_types.size();
+}
+
+bool Grid::in_bounds(int32_t x, int32_t y) const noexcept {
+    return x >= 0 && y >= 0 && x < m_width && y < m_height;
+}
+
+uint8_t Grid::type(int32_t x, int32_t y) const noexcept {
+    return m_types[index(x, y)];
+}
+
+bool Grid::is_wall(int32_t x, int32_t y) const noexcept {
+    return m_types[index(x, y)] & wall;
+}
+
+uint8_t Grid::neighbours(int32_t x, int32_t y) const noexcept {
+    return m_neighbours[index(x, y)];
+}
+
+SpacePoint Grid::shelf_position(int32_t k) const {
+    return m_shelves[static_cast<size_t>(k)];
+}
+
+int32_t Grid::robot_index(int32_t id) const {
+    if (m_robot_index.empty()) {
+        const auto it = std::lower_bound(m_sorted_robot_ids.begin(), m_sorted_robot_ids.end(),
+                                         std::make_pair(id, INT32_MIN));
+        return it != m_sorted_robot_ids.end() && it->first == id ? it->second : -1;
+    }
+    const auto k = int64_t{id} - m_min_robot_id;
+    if (k < 0 || k >= static_cast<int64_t>(m_robot_index.size())) {
+        return -1;
+    }
+    return m_robot_index[static_cast<size_t>(k)];
+}
+
+SpacePoint Grid::robot_position(int32_t id) const {
+    return m_robots[static_cast<size_t>(robot_index(id))];
+}
+
+size_t Grid::index(int32_t x, int32_t y) const noexcept {
+    return static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x);
+}
+
+void Grid::set_type(SpacePoint p, uint8_t bits) {
+    if (in_bounds(p.x, p.y)) {
+        m_types[index(p.x, p.y)] |= bits;
+    }
+}
+
+void Grid::compute_neighbours() {
+    m_neighbours.assign(m_types.size(), 0);
+    const auto open = [this](int32_t x, int32_t y) {
+        return in_bounds(x, y) && !is_wall(x, y);
+    };
+    for (int32_t y{0}; y < m_height; ++y) {
+        for (int32_t x{0}; x < m_width; ++x) {
+            uint8_t mask{0};
+            mask |= open(x - 1, y) ? left : 0u;
+            mask |= open(x + 1, y) ? right : 0u;
+            mask |= open(x, y - 1) ? up : 0u;
+            mask |= open(x, y + 1) ? down : 0u;
+            m_neighbours[index(x, y)] = mask;
+        }
+    }
+}
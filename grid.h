@@ -0,0 +1,85 @@
+#ifndef MAPF_GRID_H
+#define MAPF_GRID_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "input_parsing.h"
+
+/* The static part of an instance compiled into flat per cell tables, built once before solving. Every cell has a set
+ * of type bits and a mask of the directions that lead to another cell inside the grid which isn't a wall, so moving
+ * around only needs a table lookup. Shelves are found by their index in inst.shelf_positions, robots by their id.
+ */
+class Grid {
+public:
+    // cell type bits, a free cell has none of them
+    static constexpr uint8_t wall = 1u;
+    static constexpr uint8_t shelf = 2u;
+    static constexpr uint8_t charger = 4u;
+    static constexpr uint8_t robot_start = 8u;
+
+    // direction bits of a neighbour mask
+    static constexpr uint8_t left = 1u;
+    static constexpr uint8_t right = 2u;
+    static constexpr uint8_t up = 4u;
+    static constexpr uint8_t down = 8u;
+
+    /*
+     * An empty grid without any walls, shelves or robots.
+     */
+    Grid(int32_t width, int32_t height);
+
+    explicit Grid(const Instance &inst);
+
+    int32_t width() const noexcept;
+
+    int32_t height() const noexcept;
+
+    size_t cells() const noexcept;
+
+    bool in_bounds(int32_t x, int32_t y) const noexcept;
+
+    /*
+     * @return the type bits of (x, y), which has to be in bounds
+     */
+    uint8_t type(int32_t x, int32_t y) const noexcept;
+
+    bool is_wall(int32_t x, int32_t y) const noexcept;
+
+    /*
+     * @return the directions in which (x, y) has a neighbour that isn't a wall, (x, y) has to be in bounds
+     */
+    uint8_t neighbours(int32_t x, int32_t y) const noexcept;
+
+    SpacePoint shelf_position(int32_t k) const;
+
+    /*
+     * @return the index of robot id in inst.robot_positions, -1 if there is no such robot
+     */
+    int32_t robot_index(int32_t id) const;
+
+    /*
+     * @return the start field of robot id, which has to exist
+     */
+    SpacePoint robot_position(int32_t id) const;
+
+private:
+    size_t index(int32_t x, int32_t y) const noexcept;
+
+    void set_type(SpacePoint p, uint8_t bits);
+
+    void compute_neighbours();
+
+    int32_t m_width;
+    int32_t m_height;
+    std::vector<uint8_t> m_types;
+    std::vector<uint8_t> m_neighbours;
+    std::vector<SpacePoint> m_shelves;
+    std::vector<SpacePoint> m_robots;
+    int32_t m_min_robot_id;
+    std::vector<int32_t> m_robot_index; // by id - m_min_robot_id, empty if the ids are too sparse
+    std::vector<std::pair<int32_t, int32_t>> m_sorted_robot_ids; // (id, index)
+};
+
+#endif //MAPF_GRID_H
@@ -0,0 +1,407 @@
+#include "hpa.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <type_traits>
+
+#include "distance_table.h"
+#include "search_context.h"
+
+namespace {
+    // openings at least that wide get an entrance at either end, narrower ones a single one in the middle
+    constexpr int32_t wide_opening{6};
+    // legs that don't cross at least that many clusters are left to a_star
+    constexpr int32_t min_clusters_crossed{3};
+
+    /* Buffers of the abstract search, reused by all searches of a thread.
+     */
+    struct AbstractBuffers {
+        std::vector<uint32_t> cost;
+        std::vector<int32_t> parent;
+        std::vector<uint32_t> visited; // search number of the last search that reached a node
+        uint32_t search{0};
+        std::vector<uint32_t> start_distances;
+        std::vector<uint32_t> goal_distances;
+    };
+
+    AbstractBuffers &abstract_buffers() {
+        thread_local AbstractBuffers buffers;
+        return buffers;
+    }
+
+    /* The counts in front of the data of a ClusterGraph, and a word of padding.
+     */
+    struct GraphCounts {
+        uint32_t nodes;
+        uint32_t edges;
+        uint32_t clusters;
+        uint32_t reserved;
+    };
+
+    /*
+     * @return the length of the data of a ClusterGraph, see ClusterGraph::attach
+     */
+    size_t graph_bytes(size_t nodes, size_t edges, size_t clusters) {
+        return sizeof(GraphCounts) + (4 * nodes + 2 * edges + clusters + 2) * sizeof(uint32_t);
+    }
+}
+
+struct ClusterGraph::Builder {
+    std::vector<SpacePoint> nodes;
+    std::vector<std::vector<Edge>> edges;
+    std::vector<std::vector<int32_t>> cluster_nodes;
+    std::vector<int32_t> node_of_cell;
+};
+
+ClusterGraph::ClusterGraph(std::shared_ptr<const Grid> grid, int32_t cluster_size, Empty)
+        : m_grid(std::move(grid)), m_size{std::max(cluster_size, 2)},
+          m_clusters_x{(m_grid->width() + m_size - 1) / m_size},
+          m_clusters{static_cast<size_t>(m_clusters_x) * static_cast<size_t>((m_grid->height() + m_size - 1) / m_size)},
+          m_node_count{0}, m_nodes{nullptr}, m_edge_begin{nullptr}, m_edges{nullptr}, m_cluster_begin{nullptr},
+          m_cluster_nodes{nullptr} {}
+
+ClusterGraph::ClusterGraph(std::shared_ptr<const Grid> grid, int32_t cluster_size)
+        : ClusterGraph(std::move(grid), cluster_size, Empty{}) {
+    const auto width = m_grid->width();
+    const auto height = m_grid->height();
+    Builder builder;
+    builder.cluster_nodes.resize(m_clusters);
+    builder.node_of_cell.assign(m_grid->cells(), -1);
+
+    // entrances on the borders between clusters, columns first, then rows
+    for (int32_t x{m_size - 1}; x + 1 < width; x += m_size) {
+        for (int32_t y{0}; y < height; y += m_size) {
+            add_entrances(builder, x, y, 0, 1, std::min(m_size, height - y), Grid::right);
+        }
+    }
+    for (int32_t y{m_size - 1}; y + 1 < height; y += m_size) {
+        for (int32_t x{0}; x < width; x += m_size) {
+            add_entrances(builder, x, y, 1, 0, std::min(m_size, width - x), Grid::down);
+        }
+    }
+
+    // the ways between the entrances of each cluster
+    std::vector<uint32_t> distances;
+    size_t edge_count{0};
+    for (const auto &cluster : builder.cluster_nodes) {
+        for (const auto from : cluster) {
+            cluster_bfs(builder.nodes[from], distances);
+            for (const auto to : cluster) {
+                const auto d = cluster_distance(distances, builder.nodes[to]);
+                if (to != from && d != UINT32_MAX) {
+                    builder.edges[from].push_back({to, d});
+                }
+            }
+            edge_count += builder.edges[from].size();
+        }
+    }
+
+    // the rows of the graph, typed, before they are copied into one block
+    const auto node_count = builder.nodes.size();
+    std::vector<uint32_t> edge_begin{0};
+    std::vector<Edge> edges;
+    edges.reserve(edge_count);
+    for (const auto &node_edges : builder.edges) {
+        edges.insert(edges.end(), node_edges.begin(), node_edges.end());
+        edge_begin.push_back(static_cast<uint32_t>(edges.size()));
+    }
+    std::vector<uint32_t> cluster_begin{0};
+    std::vector<int32_t> cluster_nodes;
+    cluster_nodes.reserve(node_count);
+    for (const auto &cluster : builder.cluster_nodes) {
+        cluster_nodes.insert(cluster_nodes.end(), cluster.begin(), cluster.end());
+        cluster_begin.push_back(static_cast<uint32_t>(cluster_nodes.size()));
+    }
+
+    // Flatten it into one block: the counts, then the nodes, the edge row starts, the edges, the cluster row starts
+    // and the nodes of the clusters, see attach. The buffer is of 8 byte words, so the block is aligned for all of it.
+    const GraphCounts counts{static_cast<uint32_t>(node_count), static_cast<uint32_t>(edge_count),
+                             static_cast<uint32_t>(m_clusters), 0};
+    const auto bytes = graph_bytes(node_count, edge_count, m_clusters);
+    auto buffer = std::make_shared<std::vector<uint64_t>>((bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+    auto out = reinterpret_cast<char *>(buffer->data());
+    const auto append = [&out](const void *from, size_t size) {
+        std::memcpy(out, from, size);
+        out += size;
+    };
+    append(&counts, sizeof(counts));
+    append(builder.nodes.data(), node_count * sizeof(SpacePoint));
+    append(edge_begin.data(), edge_begin.size() * sizeof(uint32_t));
+    append(edges.data(), edges.size() * sizeof(Edge));
+    append(cluster_begin.data(), cluster_begin.size() * sizeof(uint32_t));
+    append(cluster_nodes.data(), cluster_nodes.size() * sizeof(int32_t));
+    const std::string_view data(reinterpret_cast<const char *>(buffer->data()), bytes);
+    attach(data, std::move(buffer));
+}
+
+std::unique_ptr<const ClusterGraph>
+ClusterGraph::from_data(std::shared_ptr<const Grid> grid, int32_t cluster_size, std::string_view data,
+                        std::shared_ptr<const void> storage) {
+    std::unique_ptr<ClusterGraph> graph(new ClusterGraph(std::move(grid), cluster_size, Empty{}));
+    if (!graph->attach(data, std::move(storage))) {
+        return nullptr;
+    }
+    return graph;
+}
+
+bool ClusterGraph::attach(std::string_view data, std::shared_ptr<const void> storage) {
+    // the rows are used right where they are in data, so their types have to be plain 4 byte aligned words
+    static_assert(std::is_trivially_copyable_v<SpacePoint> && sizeof(SpacePoint) == 2 * sizeof(int32_t)
+                  && alignof(SpacePoint) == alignof(uint32_t), "nodes are stored as two int32_t");
+    static_assert(std::is_trivially_copyable_v<Edge> && sizeof(Edge) == 2 * sizeof(uint32_t)
+                  && alignof(Edge) == alignof(uint32_t), "edges are stored as two 4 byte words");
+    static_assert(std::is_trivially_copyable_v<GraphCounts> && sizeof(GraphCounts) % alignof(uint64_t) == 0,
+                  "the rows following the counts have to stay aligned");
+
+    GraphCounts counts{};
+    if (data.size() < sizeof(counts) || reinterpret_cast<uintptr_t>(data.data()) % alignof(uint32_t) != 0) {
+        return false;
+    }
+    std::memcpy(&counts, data.data(), sizeof(counts));
+    const size_t node_count{counts.nodes};
+    const size_t edge_count{counts.edges};
+    if (counts.clusters != m_clusters || data.size() != graph_bytes(node_count, edge_count, m_clusters)) {
+        return false;
+    }
+    const auto nodes = data.data() + sizeof(counts);
+    const auto edge_begin = nodes + node_count * sizeof(SpacePoint);
+    const auto edges = edge_begin + (node_count + 1) * sizeof(uint32_t);
+    const auto cluster_begin = edges + edge_count * sizeof(Edge);
+    const auto cluster_nodes = cluster_begin + (m_clusters + 1) * sizeof(uint32_t);
+    m_edge_begin = reinterpret_cast<const uint32_t *>(edge_begin);
+    m_cluster_begin = reinterpret_cast<const uint32_t *>(cluster_begin);
+    if (m_edge_begin[node_count] != edge_count || m_cluster_begin[m_clusters] != node_count) {
+        m_edge_begin = nullptr;
+        m_cluster_begin = nullptr;
+        return false;
+    }
+    m_storage = std::move(storage);
+    m_data = data;
+    m_node_count = node_count;
+    m_nodes = reinterpret_cast<const SpacePoint *>(nodes);
+    m_edges = reinterpret_cast<const Edge *>(edges);
+    m_cluster_nodes = reinterpret_cast<const int32_t *>(cluster_nodes);
+    return true;
+}
+
+int32_t ClusterGraph::cluster_of(int32_t x, int32_t y) const noexcept {
+    return (y / m_size) * m_clusters_x + x / m_size;
+}
+
+int32_t ClusterGraph::add_node(Builder &builder, SpacePoint p) const {
+    auto &id = builder.node_of_cell[static_cast<size_t>(p.y) * m_grid->width() + p.x];
+    if (id < 0) {
+        id = static_cast<int32_t>(builder.nodes.size());
+        builder.nodes.push_back(p);
+        builder.edges.emplace_back();
+        builder.cluster_nodes[cluster_of(p.x, p.y)].push_back(id);
+    }
+    return id;
+}
+
+void ClusterGraph::add_entrances(Builder &builder, int32_t x, int32_t y, int32_t ax, int32_t ay, int32_t length,
+                                 uint8_t direction) const {
+    const auto dx = direction == Grid::right ? 1 : 0;
+    const auto dy = direction == Grid::down ? 1 : 0;
+    const auto add_transition = [&](int32_t k) {
+        const SpacePoint near(x + k * ax, y + k * ay);
+        const SpacePoint far(near.x + dx, near.y + dy);
+        const auto n1 = add_node(builder, near);
+        const auto n2 = add_node(builder, far);
+        builder.edges[n1].push_back({n2, 1});
+        builder.edges[n2].push_back({n1, 1});
+    };
+
+    for (int32_t begin{0}; begin < length;) {
+        if (!(m_grid->neighbours(x + begin * ax, y + begin * ay) & direction)) {
+            ++begin;
+            continue;
+        }
+        auto end = begin + 1;
+        while (end < length && (m_grid->neighbours(x + end * ax, y + end * ay) & direction)) {
+            ++end;
+        }
+        if (end - begin >= wide_opening) {
+            add_transition(begin);
+            add_transition(end - 1);
+        } else {
+            add_transition(begin + (end - begin) / 2);
+        }
+        begin = end;
+    }
+}
+
+void ClusterGraph::cluster_bfs(SpacePoint p, std::vector<uint32_t> &distances) const {
+    distances.assign(static_cast<size_t>(m_size) * static_cast<size_t>(m_size), UINT32_MAX);
+    const auto left = (p.x / m_size) * m_size;
+    const auto top = (p.y / m_size) * m_size;
+    const auto local = [&](int32_t x, int32_t y) {
+        return static_cast<size_t>(y - top) * static_cast<size_t>(m_size) + static_cast<size_t>(x - left);
+    };
+    const auto inside = [&](int32_t x, int32_t y) {
+        return x >= left && y >= top && x < left + m_size && y < top + m_size;
+    };
+
+    std::vector<SpacePoint> queue{p};
+    distances[local(p.x, p.y)] = 0;
+    for (size_t k{0}; k < queue.size(); ++k) {
+        const auto curr = queue[k];
+        const auto d = distances[local(curr.x, curr.y)] + 1;
+        const auto mask = m_grid->neighbours(curr.x, curr.y);
+        const SpacePoint next[] = {{curr.x - 1, curr.y}, {curr.x + 1, curr.y}, {curr.x, curr.y - 1},
+                                   {curr.x, curr.y + 1}};
+        const uint8_t directions[] = {Grid::left, Grid::right, Grid::up, Grid::down};
+        for (size_t i{0}; i < 4; ++i) {
+            const auto n = next[i];
+            if ((mask & directions[i]) && inside(n.x, n.y) && distances[local(n.x, n.y)] == UINT32_MAX) {
+                distances[local(n.x, n.y)] = d;
+                queue.push_back(n);
+            }
+        }
+    }
+}
+
+uint32_t ClusterGraph::cluster_distance(const std::vector<uint32_t> &distances, SpacePoint p) const noexcept {
+    return distances[static_cast<size_t>(p.y % m_size) * static_cast<size_t>(m_size)
+                     + static_cast<size_t>(p.x % m_size)];
+}
+
+bool ClusterGraph::abstract_path(SpacePoint start, SpacePoint goal, std::vector<SpacePoint> &waypoints) const {
+    waypoints.clear();
+    if (m_grid->is_wall(start.x, start.y) || m_grid->is_wall(goal.x, goal.y)) {
+        return false;
+    }
+
+    // start and goal are two more nodes for this search, connected to the entrances of their clusters
+    auto &buffers = abstract_buffers();
+    const auto start_id = static_cast<int32_t>(m_node_count);
+    const auto goal_id = start_id + 1;
+    const auto count = m_node_count + 2;
+    if (buffers.visited.size() < count) {
+        buffers.cost.resize(count);
+        buffers.parent.resize(count);
+        buffers.visited.resize(count, 0);
+    }
+    if (++buffers.search == 0) { // wrapped around, every old mark could look current
+        std::fill(buffers.visited.begin(), buffers.visited.end(), 0);
+        buffers.search = 1;
+    }
+    cluster_bfs(start, buffers.start_distances);
+    cluster_bfs(goal, buffers.goal_distances);
+    const auto start_cluster = cluster_of(start.x, start.y);
+    const auto goal_cluster = cluster_of(goal.x, goal.y);
+    const auto point_of = [&](int32_t id) {
+        return id == start_id ? start : id == goal_id ? goal : m_nodes[id];
+    };
+
+    using Entry = std::pair<uint32_t, int32_t>; // f, node
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    const auto reach = [&](int32_t id, int32_t parent, uint32_t cost) {
+        if (buffers.visited[id] == buffers.search && buffers.cost[id] <= cost) {
+            return;
+        }
+        buffers.visited[id] = buffers.search;
+        buffers.cost[id] = cost;
+        buffers.parent[id] = parent;
+        open.emplace(cost + manhatten_distance(point_of(id), goal), id);
+    };
+
+    reach(start_id, -1, 0);
+    while (!open.empty()) {
+        const auto [f, curr] = open.top();
+        open.pop();
+        const auto cost = buffers.cost[curr];
+        if (f != cost + manhatten_distance(point_of(curr), goal)) { // outdated entry
+            continue;
+        }
+        if (curr == goal_id) {
+            for (auto id = goal_id; id != start_id; id = buffers.parent[id]) {
+                waypoints.push_back(point_of(id));
+            }
+            std::reverse(waypoints.begin(), waypoints.end());
+            return true;
+        }
+
+        const auto p = point_of(curr);
+        if (cluster_of(p.x, p.y) == goal_cluster) {
+            const auto d = cluster_distance(buffers.goal_distances, p);
+            if (d != UINT32_MAX) {
+                reach(goal_id, curr, cost + d);
+            }
+        }
+        if (curr == start_id) {
+            for (auto k = m_cluster_begin[start_cluster]; k < m_cluster_begin[start_cluster + 1]; ++k) {
+                const auto to = m_cluster_nodes[k];
+                const auto d = cluster_distance(buffers.start_distances, m_nodes[to]);
+                if (d != UINT32_MAX) {
+                    reach(to, curr, d);
+                }
+            }
+            continue;
+        }
+        for (auto k = m_edge_begin[curr]; k < m_edge_begin[curr + 1]; ++k) {
+            reach(m_edges[k].to, curr, cost + m_edges[k].cost);
+        }
+    }
+    return false;
+}
+
+int32_t ClusterGraph::cluster_size() const noexcept {
+    return m_size;
+}
+
+size_t ClusterGraph::nodes() const noexcept {
+    return m_node_count;
+}
+
+std::string_view ClusterGraph::data() const noexcept {
+    return m_data;
+}
+
+CompactPath
+a_star_hierarchical(const SpaceTimePoint start, const SpacePoint goal, uint32_t rest_after, int32_t charge,
+                    uint32_t width, uint32_t height, const ReservationTable &reservations,
+                    const DistanceTable *distances, SearchContext &context) {
+    const auto flat = [&]() {
+        return a_star(start, goal, rest_after, charge, width, height, reservations, distances, context);
+    };
+    if (!distances) {
+        return flat();
+    }
+    const auto &graph = distances->clusters();
+    if (static_cast<int32_t>(manhatten_distance(start, goal)) < min_clusters_crossed * graph.cluster_size()) {
+        return flat();
+    }
+    thread_local std::vector<SpacePoint> waypoints;
+    if (!graph.abstract_path(SpacePoint(start), goal, waypoints)) {
+        return CompactPath{};
+    }
+
+    // Refine from entrance to entrance, the first field of an entrance is skipped as the step through it is part of
+    // the way to the second one anyway. Only the last piece knows a distance field, the others are short.
+    CompactPath path(start);
+    int32_t used_charge{0};
+    for (size_t k{0}; k < waypoints.size(); ++k) {
+        const auto last = k + 1 == waypoints.size();
+        if (!last && manhatten_distance(waypoints[k], waypoints[k + 1]) == 1) {
+            continue;
+        }
+        const auto from = path.back();
+        if (SpacePoint(from) == waypoints[k] && !last) {
+            continue;
+        }
+        const auto piece = a_star(from, waypoints[k], last ? rest_after : 0, charge - used_charge, width, height,
+                                  reservations, last ? distances : nullptr, context);
+        if (piece.empty()) {
+            return flat();
+        }
+        used_charge += get_used_charge(piece);
+        for (size_t m{0}; m < piece.moves(); ++m) {
+            path.push_back(piece.move(m));
+        }
+    }
+    return path;
+}
@@ -0,0 +1,122 @@
+#ifndef MAPF_HPA_H
+#define MAPF_HPA_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "compact_path.h"
+#include "grid.h"
+#include "pathfinding.h"
+
+/* The abstract graph of hierarchical path planning (HPA*). The grid is cut into square clusters of cluster_size
+ * fields. Wherever two neighbouring clusters touch without a wall in between there are entrances, one pair of fields
+ * (one on either side) in the middle of a short opening, or one at each end of a long one. The fields of the entrances
+ * are the nodes of the graph, the edges are the steps through an entrance and the shortest ways between the entrances
+ * of a cluster inside it. Only walls count, the graph is built once per grid and never changes.
+ *
+ * The graph is kept in compressed rows in a single block of memory, so it can be stored in and used straight from the
+ * layout cache.
+ */
+class ClusterGraph {
+public:
+    static constexpr int32_t default_cluster_size{16};
+
+    explicit ClusterGraph(std::shared_ptr<const Grid> grid, int32_t cluster_size = default_cluster_size);
+
+    /*
+     * The graph data() of an earlier graph of the same grid and cluster size returned. It is used where it is,
+     * storage has to own data.
+     * @return nullptr if data doesn't hold a graph of that size
+     */
+    static std::unique_ptr<const ClusterGraph> from_data(std::shared_ptr<const Grid> grid, int32_t cluster_size,
+                                                         std::string_view data, std::shared_ptr<const void> storage);
+
+    /*
+     * Finds the shortest way from start to goal on the graph, start and goal are connected to the entrances of their
+     * clusters for the search.
+     * @param waypoints the entrances along the way followed by goal, start isn't part of it
+     * @return false if there is no way
+     */
+    bool abstract_path(SpacePoint start, SpacePoint goal, std::vector<SpacePoint> &waypoints) const;
+
+    int32_t cluster_size() const noexcept;
+
+    size_t nodes() const noexcept;
+
+    /*
+     * @return the whole graph as one block of memory, see from_data
+     */
+    std::string_view data() const noexcept;
+
+private:
+    struct Edge {
+        int32_t to;
+        uint32_t cost;
+    };
+
+    // the graph while it is built, with a vector per node and cluster
+    struct Builder;
+
+    // tells the constructor to leave the graph empty
+    struct Empty {
+    };
+
+    ClusterGraph(std::shared_ptr<const Grid> grid, int32_t cluster_size, Empty);
+
+    int32_t cluster_of(int32_t x, int32_t y) const noexcept;
+
+    int32_t add_node(Builder &builder, SpacePoint p) const;
+
+    /*
+     * Adds the entrances on the openings between (x, y) and (x + dx, y + dy) for length fields along (ax, ay).
+     */
+    void add_entrances(Builder &builder, int32_t x, int32_t y, int32_t ax, int32_t ay, int32_t length,
+                       uint8_t direction) const;
+
+    /*
+     * Points the graph into data, which the constructor wrote, the rows are used where they are.
+     * @return false if data doesn't hold a graph with the number of clusters of this one
+     */
+    bool attach(std::string_view data, std::shared_ptr<const void> storage);
+
+    /*
+     * Breadth first search from p that doesn't leave the cluster of p.
+     * @param distances per field of the cluster (row by row), unreachable ones are left at UINT32_MAX
+     */
+    void cluster_bfs(SpacePoint p, std::vector<uint32_t> &distances) const;
+
+    /*
+     * @return the distance of p from the search of cluster_bfs that started in the cluster of p
+     */
+    uint32_t cluster_distance(const std::vector<uint32_t> &distances, SpacePoint p) const noexcept;
+
+    std::shared_ptr<const Grid> m_grid;
+    int32_t m_size;
+    int32_t m_clusters_x;
+    size_t m_clusters;
+    // The edges of node n are m_edges[m_edge_begin[n]] up to m_edges[m_edge_begin[n + 1]], the nodes of a cluster
+    // are listed the same way. All of it lives in m_storage, a buffer of its own or a mapped layout file.
+    std::shared_ptr<const void> m_storage;
+    std::string_view m_data;
+    size_t m_node_count;
+    const SpacePoint *m_nodes;
+    const uint32_t *m_edge_begin;
+    const Edge *m_edges;
+    const uint32_t *m_cluster_begin;
+    const int32_t *m_cluster_nodes;
+};
+
+/**
+ * Hierarchical drop-in replacement for a_star (HPA*). Legs that cross several clusters are searched on the
+ * ClusterGraph of distances first, then refined against the reservations one entrance after another with a_star, so
+ * every search stays within about two clusters. If a piece can't be refined, the whole leg is planned by a_star after
+ * all. Shorter legs, or calls without distances, go to a_star directly.
+ */
+CompactPath
+a_star_hierarchical(SpaceTimePoint start, SpacePoint goal, uint32_t rest_after, int32_t charge, uint32_t width,
+                    uint32_t height, const ReservationTable &reservations, const DistanceTable *distances,
+                    SearchContext &context);
+
+#endif //MAPF_HPA_H
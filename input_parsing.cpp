@@ -2,91 +2,347 @@
 // Created by khondar on 01.02.20.
 //
 
-#include <fstream>
+#include <algorithm>
+#include <charconv>
 #include <iostream>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "input_parsing.h"
+#include "compact_path.h"
+#include "mapped_file.h"
 
-bool read_lines(const std::string &filename, std::vector<std::string> &lines) {
-    std::ifstream input(filename.c_str());
-    if (!input) {
+namespace {
+    /* Hands out the lines of a text one after another as views into it.
+     */
+    class LineScanner {
+    public:
+        explicit LineScanner(std::string_view text) : m_rest{text}, m_line{0} {}
+
+        bool at_end() const {
+            return m_rest.empty();
+        }
+
+        std::string_view peek() const {
+            auto line = m_rest.substr(0, m_rest.find('\n'));
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            return line;
+        }
+
+        std::string_view next() {
+            const auto line = peek();
+            const auto end = m_rest.find('\n');
+            m_rest.remove_prefix(end == std::string_view::npos ? m_rest.size() : end + 1);
+            ++m_line;
+            return line;
+        }
+
+        /*
+         * @return number of the line next() returned last, starting at 1
+         */
+        size_t line_number() const {
+            return m_line;
+        }
+
+    private:
+        std::string_view m_rest;
+        size_t m_line;
+    };
+
+    /*
+     * Removes the first whitespace separated token from s.
+     * @return the token, empty if there is none
+     */
+    std::string_view next_token(std::string_view &s) {
+        const auto begin = s.find_first_not_of(" \t");
+        if (begin == std::string_view::npos) {
+            s = std::string_view{};
+            return s;
+        }
+        s.remove_prefix(begin);
+        const auto token = s.substr(0, s.find_first_of(" \t"));
+        s.remove_prefix(token.size());
+        return token;
+    }
+
+    bool to_int(std::string_view s, int32_t &value) {
+        const auto result = std::from_chars(s.data(), s.data() + s.size(), value);
+        return result.ec == std::errc() && result.ptr == s.data() + s.size();
+    }
+
+    /*
+     * @return false, to be passed on by the parse functions
+     */
+    bool invalid(const std::string &what) {
+        std::cout << "Invalid instance, " << what << "\n";
         return false;
     }
 
-    for (std::string line; std::getline(input, line);) {
-        if (!line.empty() && line.at(line.length() - 1) == '\n') {
-            line.erase(line.length() - 1);
+    /*
+     * Reads an 'id start goal' line, find_shelf maps a shelf name to its index or -1.
+     */
+    template<typename ShelfLookup>
+    bool parse_delivery_line(std::string_view line, const ShelfLookup &find_shelf, Delivery &d) {
+        const auto id = next_token(line);
+        const auto start = next_token(line);
+        const auto goal = next_token(line);
+        if (goal.empty() || !next_token(line).empty()) {
+            return false;
+        }
+        // loading and unloading are written as the id, one char per robot and time step, which must not read like a
+        // move
+        if (id.size() != 1) {
+            std::cout << "Package ids have to be a single char, the output has one char per action\n";
+            return false;
         }
-        lines.push_back(line);
+        if (is_move_char(id.front())) {
+            std::cout << "Package ids can't be S, U, D, L or R, those are the actions of moving and staying\n";
+            return false;
+        }
+        d.id = id.front();
+        d.start = find_shelf(start);
+        d.goal = find_shelf(goal);
+        return d.start >= 0 && d.goal >= 0;
     }
-    return true;
-}
 
-Instance parse_instance(const std::string &filename) {
-    std::vector<std::string> lines;
+    /* The robot ids and shelf names used so far, each of them names one object only.
+     */
+    class ObjectNames {
+    public:
+        /*
+         * @return false if id is taken already, the reason has been printed
+         */
+        bool add_robot(int32_t id, size_t line) {
+            if (!m_robots.insert(id).second) {
+                return invalid("robot " + std::to_string(id) + " is there twice, line " + std::to_string(line));
+            }
+            return true;
+        }
 
-    if (!read_lines(filename, lines)) {
-        std::cout << "Cannot open the file: " << filename << "\n";
-        std::exit(1);
+        /*
+         * @return false if name is taken already, the reason has been printed
+         */
+        bool add_shelf(std::string_view name, size_t line) {
+            if (!m_shelves.emplace(name).second) {
+                return invalid("shelf " + std::string(name) + " is there twice, line " + std::to_string(line));
+            }
+            return true;
+        }
+
+    private:
+        std::unordered_set<int32_t> m_robots;
+        std::unordered_set<std::string> m_shelves;
+    };
+
+    /*
+     * Cells of the original format, which the extended grid understands as well.
+     * @return false if the cell names a robot or shelf a second time, the reason has been printed
+     */
+    bool parse_cell(char c, int32_t x, int32_t y, size_t line, ObjectNames &names, Instance &inst) {
+        if (c >= 'A' && c <= 'Z') { // Capital letter
+            inst.shelf_positions.emplace_back(std::string(1, c), SpacePoint(x, y));
+            return names.add_shelf(inst.shelf_positions.back().first, line);
+        } else if (c == '_') { // _ charging station
+            inst.charger_positions.emplace_back(x, y);
+        } else if (c >= '0' && c <= '9') { // digit
+            inst.robot_positions.emplace_back(c - '0', SpacePoint(x, y));
+            return names.add_robot(c - '0', line);
+        } else if (c == '#') { // wall inside of the warehouse
+            inst.wall_positions.emplace_back(x, y);
+        }
+        return true;
     }
-    if (lines.empty()) {
-        std::cout << "Empty instance, what the heck?\n";
-        std::exit(0);
+
+    bool parse_original_grid(LineScanner &scanner, ObjectNames &names, Instance &inst) {
+        inst.width = static_cast<int32_t>(scanner.next().length()) - 2;
+        inst.height = 0;
+
+        int32_t y{0};
+        for (; !scanner.at_end(); ++y) { // parse the grid itself
+            const auto l = scanner.peek();
+            if (!l.empty() && l.front() != '#') {
+                break;
+            }
+            scanner.next();
+            if (l.length() != static_cast<size_t>(inst.width) + 2) {
+                std::cout << "Line " << scanner.line_number() - 1 << " in instance is too short\n";
+                return false;
+            }
+            for (int32_t x{0}; x < inst.width; ++x) { // skip left and right wall
+                if (!parse_cell(l[x + 1], x, y, scanner.line_number(), names, inst)) {
+                    return false;
+                }
+            }
+        }
+        inst.height = y - 1;
+        if (inst.height < 0) {
+            return invalid("grid needed");
+        }
+        // the last grid line was the lower outer wall, not part of the warehouse
+        inst.wall_positions.erase(std::remove_if(inst.wall_positions.begin(), inst.wall_positions.end(),
+                                                 [&](const SpacePoint w) { return w.y >= inst.height; }),
+                                  inst.wall_positions.end());
+        return true;
     }
 
-    Instance inst;
-    inst.width = static_cast<int32_t >(lines.at(0).length()) - 2;
-    inst.height = 0;
+    /*
+     * Reads '<keyword> <n>'.
+     */
+    bool parse_count(LineScanner &scanner, std::string_view keyword, int32_t &n) {
+        auto line = scanner.next();
+        if (next_token(line) != keyword || !to_int(next_token(line), n) || n < 0) {
+            return invalid(std::string(keyword) + " <n> needed in line " + std::to_string(scanner.line_number()));
+        }
+        return true;
+    }
 
-    size_t i{1};
-    for (; i < lines.size(); ++i) { // parse the grid itself
-        const auto l = lines.at(i);
-        if (!l.empty() && l.at(0) != '#') {
-            break;
+    /*
+     * Reads n lines '<name> <x> <y>' of objects that have to be on a free field inside the grid, add returns false for
+     * a bad name. cells holds the char of every field of the grid, the objects are marked in it.
+     */
+    template<typename Add>
+    bool parse_objects(LineScanner &scanner, int32_t n, const Instance &inst, std::vector<char> &cells,
+                       const Add &add) {
+        for (int32_t k{0}; k < n; ++k) {
+            auto line = scanner.next();
+            const auto name = next_token(line);
+            int32_t x{0};
+            int32_t y{0};
+            if (!to_int(next_token(line), x) || !to_int(next_token(line), y)
+                || x < 0 || y < 0 || x >= inst.width || y >= inst.height) {
+                return invalid("bad position in line " + std::to_string(scanner.line_number()));
+            }
+            auto &cell = cells[static_cast<size_t>(y) * static_cast<size_t>(inst.width) + static_cast<size_t>(x)];
+            if (cell == '#') {
+                return invalid("position on a wall in line " + std::to_string(scanner.line_number()));
+            }
+            if (cell != '.') {
+                return invalid("position taken by another object in line " + std::to_string(scanner.line_number()));
+            }
+            cell = 'o';
+            if (!add(name, SpacePoint(x, y))) {
+                return false;
+            }
         }
-        if (l.length() != static_cast<size_t>(inst.width) + 2) {
-            std::cout << "Line " << i << " in instance is too short\n";
-            std::exit(1);
+        return true;
+    }
+
+    bool parse_extended_grid(LineScanner &scanner, ObjectNames &names, Instance &inst) {
+        scanner.next(); // 'extended'
+        auto header = scanner.next();
+        if (next_token(header) != "grid" || !to_int(next_token(header), inst.width)
+            || !to_int(next_token(header), inst.height) || inst.width <= 0 || inst.height <= 0) {
+            return invalid("grid <width> <height> needed");
         }
 
-        for (size_t k{1}; k < l.length() - 1; ++k) { // skip left and right wall
-            char char_at = l[k];
-            if (char_at >= 'A' && char_at <= 'Z') { // Capital letter
-                inst.shelf_positions.emplace_back(char_at, SpacePoint(k - 1, i - 1));
-            } else if (char_at == '_') { // _ charging station
-                inst.charger_positions.emplace_back(k - 1, i - 1);
-            } else if (char_at >= '0' && char_at <= '9') { // digit
-                int32_t id = char_at - '0';
-                inst.robot_positions.emplace_back(id, SpacePoint(k - 1, i - 1));
+        std::vector<char> cells(static_cast<size_t>(inst.width) * static_cast<size_t>(inst.height));
+        for (int32_t y{0}; y < inst.height; ++y) {
+            const auto l = scanner.next();
+            if (l.length() != static_cast<size_t>(inst.width)) {
+                std::cout << "Line " << scanner.line_number() << " in instance has the wrong length\n";
+                return false;
             }
+            l.copy(cells.data() + static_cast<size_t>(y) * static_cast<size_t>(inst.width), l.length());
+            for (int32_t x{0}; x < inst.width; ++x) {
+                if (!parse_cell(l[x], x, y, scanner.line_number(), names, inst)) {
+                    return false;
+                }
+            }
+        }
+
+        int32_t robots{0};
+        if (!parse_count(scanner, "robots", robots)
+            || !parse_objects(scanner, robots, inst, cells, [&](std::string_view name, SpacePoint p) {
+                int32_t id{0};
+                if (!to_int(name, id)) {
+                    return invalid("robot ids have to be numbers, line " + std::to_string(scanner.line_number()));
+                }
+                inst.robot_positions.emplace_back(id, p);
+                return names.add_robot(id, scanner.line_number());
+            })) {
+            return false;
         }
+        int32_t shelves{0};
+        return parse_count(scanner, "shelves", shelves)
+               && parse_objects(scanner, shelves, inst, cells, [&](std::string_view name, SpacePoint p) {
+                   inst.shelf_positions.emplace_back(std::string(name), p);
+                   return names.add_shelf(name, scanner.line_number());
+               });
     }
-    inst.height = i - 2;
-    if (inst.height < 0) {
-        std::cout << "Invalid instance, grid needed\n";
-        std::exit(1);
+
+    bool parse_packages(LineScanner &scanner, Instance &inst) {
+        auto charge_line = scanner.peek();
+        if (scanner.at_end() || next_token(charge_line) != "charge" || !to_int(next_token(charge_line), inst.charge)) {
+            return invalid("charge needed");
+        }
+        scanner.next();
+        if (scanner.at_end() || scanner.next().find("packages") != 0) {
+            return invalid("packages needed");
+        }
+
+        std::unordered_map<std::string_view, int32_t> shelves;
+        for (size_t k{0}; k < inst.shelf_positions.size(); ++k) {
+            shelves.emplace(inst.shelf_positions[k].first, static_cast<int32_t>(k));
+        }
+        const auto find_shelf = [&shelves](std::string_view name) {
+            const auto it = shelves.find(name);
+            return it == shelves.end() ? -1 : it->second;
+        };
+        while (!scanner.at_end()) { // parse the needed deliveries
+            const auto line = scanner.next();
+            if (line.empty()) {
+                continue;
+            }
+            Delivery d{};
+            if (!parse_delivery_line(line, find_shelf, d)) {
+                std::cout << "Invalid delivery: " << line << "\n";
+                return false;
+            }
+            inst.deliveries.push_back(d);
+        }
+        return true;
+    }
+}
+
+bool parse_instance(const std::string &filename, Instance &inst) {
+    const MappedFile file(filename);
+    if (!file.opened()) {
+        std::cout << "Cannot open the file: " << filename << "\n";
+        return false;
+    }
+    LineScanner scanner(file.contents());
+    if (scanner.at_end()) {
+        std::cout << "Empty instance, what the heck?\n";
+        return false;
     }
 
-    if (i == lines.size() || lines.at(i).find("charge") != 0) {
-        std::cout << "Invalid instance, charge needed\n";
-        std::exit(1);
+    inst = Instance();
+    ObjectNames names;
+    const auto grid_parsed = scanner.peek() == "extended" ? parse_extended_grid(scanner, names, inst)
+                                                          : parse_original_grid(scanner, names, inst);
+    if (!grid_parsed || !parse_packages(scanner, inst)) {
+        return false;
     }
-    inst.charge = std::stoi(lines[i].substr(7));
-    i += 1; // skip next line that only says 'packages'
-    if (i == lines.size() || lines.at(i).find("packages") != 0) {
-        std::cout << "Invalid instance, packages needed\n";
-        std::exit(1);
+    // every delivery recharges on the way, so without a charger or a robot none of them can be made
+    if (!inst.deliveries.empty() && inst.charger_positions.empty()) {
+        return invalid("there are packages but no chargers");
     }
-    i += 1;
-    for (; i < lines.size(); ++i) { // parse the needed deliveries
-        const auto line = lines.at(i);
-        char id = line.at(0);
-        char start = line.at(2);
-        char goal = line.at(4);
-        inst.deliveries.push_back({id, start, goal});
+    if (!inst.deliveries.empty() && inst.robot_positions.empty()) {
+        return invalid("there are packages but no robots");
     }
+    return true;
+}
 
-    return inst;
+bool parse_delivery(const std::string &line, const Instance &inst, Delivery &d) {
+    return parse_delivery_line(line, [&inst](std::string_view name) {
+        const auto it = std::find_if(inst.shelf_positions.begin(), inst.shelf_positions.end(),
+                                     [name](const std::pair<std::string, SpacePoint> &s) { return s.first == name; });
+        return it == inst.shelf_positions.end() ? -1 : static_cast<int32_t>(it - inst.shelf_positions.begin());
+    }, d);
 }
 
 void print_instance(const Instance &inst) {
@@ -94,19 +350,22 @@ void print_instance(const Instance &inst) {
     std::cout << "height: " << inst.height << "\n";
     std::cout << "charge: " << inst.charge << "\n";
     std::cout << "shelf_positions:\n";
-    for (const auto s : inst.shelf_positions) {
+    for (const auto &s : inst.shelf_positions) {
         std::cout << "\t" << s.first << " ,x: " << s.second.x << " ,y: " << s.second.y << "\n";
     }
     std::cout << "robot_positions:\n";
-    for (const auto r : inst.robot_positions) {
+    for (const auto &r : inst.robot_positions) {
         std::cout << "\t" << r.first << ", x: " << r.second.x << " ,y: " << r.second.y << "\n";
     }
     std::cout << "charger_positions:\n";
     for (const auto c : inst.charger_positions) {
         std::cout << "\tx: " << c.x << ", y: " << c.y << "\n";
     }
+    // large layouts have millions of walls, listing them would drown everything else
+    std::cout << "walls: " << inst.wall_positions.size() << "\n";
     std::cout << "deliveries:\n";
     for (const auto d : inst.deliveries) {
-        std::cout << "\tid: " << d.id << ", start: " << d.start << ", goal: " << d.goal << "\n";
+        std::cout << "\tid: " << d.id << ", start: " << inst.shelf_positions[d.start].first
+                  << ", goal: " << inst.shelf_positions[d.goal].first << "\n";
     }
 }
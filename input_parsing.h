@@ -5,29 +5,50 @@
 #ifndef MAPF_INPUT_PARSING_H
 #define MAPF_INPUT_PARSING_H
 
+#include <string>
 #include <vector>
 
 #include "pathfinding.h"
 
 struct Delivery {
-    char id;
-    char start;
-    char goal;
+    char id;       // written to the output when loading and unloading
+    int32_t start; // index into Instance::shelf_positions
+    int32_t goal;  // index into Instance::shelf_positions
 };
 
 struct Instance {
     std::vector<std::pair<int32_t, SpacePoint>> robot_positions;
-    std::vector<std::pair<char, SpacePoint>> shelf_positions;
+    std::vector<std::pair<std::string, SpacePoint>> shelf_positions;
     std::vector<SpacePoint> charger_positions;
+    std::vector<SpacePoint> wall_positions; // walls inside the grid, the outer wall isn't included
     std::vector<Delivery> deliveries;
     int32_t width;
     int32_t height;
     int32_t charge;
 };
 
-bool read_lines(const std::string &filename, std::vector<std::string> &lines);
-
-Instance parse_instance(const std::string &filename);
+/*
+ * Loads an instance, the file is mapped into memory and parsed in place. Two formats are understood:
+ *
+ * The original one, the grid surrounded by a wall of '#', shelves 'A'-'Z', robots '0'-'9', chargers '_' and walls
+ * '#' inside, followed by 'charge <n>', 'packages' and one line 'id start goal' per package.
+ *
+ * The extended one for large warehouses, which starts with a line 'extended', followed by 'grid <width> <height>' and
+ * height lines of width chars without the outer wall ('.' free, '#' wall, '_' charger, the single char ids of the
+ * original format work as well). Then 'robots <n>' and n lines '<id> <x> <y>' with numeric ids, 'shelves <n>' and n
+ * lines '<name> <x> <y>' with names of any length, and the same charge and packages sections as the original. Package
+ * ids are single chars in both formats. Robot ids and shelf names may only be used once, and the robots and shelves of
+ * the extended sections have to be on fields that are neither walls nor taken by anything else.
+ * Instances with packages but no charger or no robot are rejected, none of the packages could be delivered.
+ * @return false if the file can't be read or isn't a valid instance, the reason has been printed already
+ */
+bool parse_instance(const std::string &filename, Instance &inst);
+
+/*
+ * Parses a line 'id start goal' of the packages section, start and goal are shelf names of inst.
+ * @return false if the line is malformed, names an unknown shelf or the id isn't a single char other than a move
+ */
+bool parse_delivery(const std::string &line, const Instance &inst, Delivery &d);
 
 void print_instance(const Instance &inst);
 
@@ -0,0 +1,95 @@
+#include "instance_generator.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+std::string generate_instance(const GeneratorConfig &config) {
+    const auto cells = static_cast<int64_t>(config.width) * config.height;
+    if (config.width <= 0 || config.height <= 0 || config.shelves < 2 || config.robots < 0 || config.chargers < 1
+        || config.packages < 0 || int64_t{config.robots} + config.shelves + config.chargers > cells) {
+        return std::string{};
+    }
+
+    std::mt19937 rng{config.seed};
+    // partial Fisher-Yates, only the fields we need are drawn
+    std::vector<int32_t> fields(static_cast<size_t>(cells));
+    for (size_t k{0}; k < fields.size(); ++k) {
+        fields[k] = static_cast<int32_t>(k);
+    }
+    const auto needed = static_cast<size_t>(config.robots + config.shelves + config.chargers);
+    for (size_t k{0}; k < needed; ++k) {
+        std::uniform_int_distribution<size_t> pick(k, fields.size() - 1);
+        std::swap(fields[k], fields[pick(rng)]);
+    }
+    auto next_field = fields.begin();
+
+    const bool original = config.robots <= 10 && config.shelves <= 26;
+    const auto row_length = static_cast<size_t>(config.width) + (original ? 3 : 1);
+    std::vector<std::string> shelf_names;
+    std::string robots;
+    std::string shelves;
+    std::string grid(static_cast<size_t>(config.height) * row_length, '.');
+    for (int32_t y{0}; y < config.height; ++y) {
+        const auto row = static_cast<size_t>(y) * row_length;
+        if (original) {
+            grid[row] = '#';
+            grid[row + row_length - 2] = '#';
+        }
+        grid[row + row_length - 1] = '\n';
+    }
+    const auto cell = [&](int32_t field) -> char & {
+        const auto x = static_cast<size_t>(field % config.width);
+        const auto y = static_cast<size_t>(field / config.width);
+        return grid[y * row_length + x + (original ? 1 : 0)];
+    };
+    const auto position = [&](int32_t field) {
+        return " " + std::to_string(field % config.width) + " " + std::to_string(field / config.width) + "\n";
+    };
+
+    for (int32_t k{0}; k < config.shelves; ++k) {
+        const auto field = *next_field++;
+        if (original) {
+            shelf_names.emplace_back(1, static_cast<char>('A' + k));
+            cell(field) = shelf_names.back().front();
+        } else {
+            shelf_names.push_back("S" + std::to_string(k));
+            shelves += shelf_names.back() + position(field);
+        }
+    }
+    for (int32_t k{0}; k < config.chargers; ++k) {
+        cell(*next_field++) = '_';
+    }
+    for (int32_t k{0}; k < config.robots; ++k) {
+        const auto field = *next_field++;
+        if (original) {
+            cell(field) = static_cast<char>('0' + k);
+        } else {
+            robots += std::to_string(k) + position(field);
+        }
+    }
+
+    std::string out;
+    if (original) {
+        const std::string outer_wall(static_cast<size_t>(config.width) + 2, '#');
+        out = outer_wall + "\n" + grid + outer_wall + "\n";
+    } else {
+        out = "extended\ngrid " + std::to_string(config.width) + " " + std::to_string(config.height) + "\n" + grid
+              + "robots " + std::to_string(config.robots) + "\n" + robots
+              + "shelves " + std::to_string(config.shelves) + "\n" + shelves;
+    }
+    // enough charge to cross the warehouse twice
+    out += "charge " + std::to_string(2 * (config.width + config.height)) + "\npackages\n";
+
+    std::uniform_int_distribution<size_t> pick_shelf(0, shelf_names.size() - 1);
+    for (int32_t k{0}; k < config.packages; ++k) {
+        const auto start = pick_shelf(rng);
+        auto goal = pick_shelf(rng);
+        while (goal == start) {
+            goal = pick_shelf(rng);
+        }
+        const auto id = std::string(1, static_cast<char>('a' + k % 26));
+        out += id + " " + shelf_names[start] + " " + shelf_names[goal] + "\n";
+    }
+    return out;
+}
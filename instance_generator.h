@@ -0,0 +1,25 @@
+#ifndef MAPF_INSTANCE_GENERATOR_H
+#define MAPF_INSTANCE_GENERATOR_H
+
+#include <cstdint>
+#include <string>
+
+struct GeneratorConfig {
+    int32_t width;
+    int32_t height;
+    int32_t robots;
+    int32_t shelves;
+    int32_t chargers;
+    int32_t packages;
+    uint32_t seed;
+};
+
+/*
+ * Places robots, shelves and chargers on distinct random fields of an empty grid and draws packages between random
+ * pairs of shelves, the same seed always gives the same instance. Instances that fit the original format (at most 10
+ * robots and 26 shelves) are written in it, larger ones in the extended format, see parse_instance.
+ * @return the instance file contents, empty if the objects don't fit on the grid
+ */
+std::string generate_instance(const GeneratorConfig &config);
+
+#endif //MAPF_INSTANCE_GENERATOR_H
@@ -0,0 +1,156 @@
+#include "layout_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr char layout_magic[8] = {'M', 'A', 'P', 'F', 'L', 'A', 'Y', '\0'};
+
+    /* 64 bit FNV-1a, enough to name the layouts of a cache directory, the files hold the layouts themselves.
+     */
+    class LayoutHash {
+    public:
+        void add(int64_t value) {
+            for (int k{0}; k < 8; ++k) {
+                m_hash ^= static_cast<uint64_t>(value >> (8 * k)) & 0xFFu;
+                m_hash *= 0x100000001B3u;
+            }
+        }
+
+        void add(SpacePoint p) {
+            add(p.x);
+            add(p.y);
+        }
+
+        uint64_t value() const {
+            return m_hash;
+        }
+
+    private:
+        uint64_t m_hash{0xCBF29CE484222325u};
+    };
+}
+
+static_assert(sizeof(LayoutHeader) % 8 == 0, "the data following the header has to stay aligned");
+
+uint64_t layout_key(const Instance &inst) {
+    LayoutHash hash;
+    hash.add(inst.width);
+    hash.add(inst.height);
+    hash.add(static_cast<int64_t>(inst.wall_positions.size()));
+    for (const auto w : inst.wall_positions) {
+        hash.add(w);
+    }
+    hash.add(static_cast<int64_t>(inst.shelf_positions.size()));
+    for (const auto &s : inst.shelf_positions) {
+        hash.add(s.second);
+    }
+    hash.add(static_cast<int64_t>(inst.charger_positions.size()));
+    for (const auto c : inst.charger_positions) {
+        hash.add(c);
+    }
+    return hash.value();
+}
+
+std::string layout_contents(const Instance &inst) {
+    std::vector<int32_t> values{inst.width, inst.height, static_cast<int32_t>(inst.wall_positions.size()),
+                                static_cast<int32_t>(inst.shelf_positions.size()),
+                                static_cast<int32_t>(inst.charger_positions.size())};
+    const auto add = [&values](SpacePoint p) {
+        values.push_back(p.x);
+        values.push_back(p.y);
+    };
+    std::for_each(inst.wall_positions.begin(), inst.wall_positions.end(), add);
+    for (const auto &s : inst.shelf_positions) {
+        add(s.second);
+    }
+    std::for_each(inst.charger_positions.begin(), inst.charger_positions.end(), add);
+    values.resize((values.size() + 1) / 2 * 2, 0);
+    return std::string(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(int32_t));
+}
+
+LayoutHeader make_layout_header(const Instance &inst, LayoutData data, uint32_t parameter) {
+    LayoutHeader header{};
+    std::memcpy(header.magic, layout_magic, sizeof(layout_magic));
+    header.version = layout_cache_version;
+    header.data = data;
+    header.key = layout_key(inst);
+    header.width = inst.width;
+    header.height = inst.height;
+    header.parameter = parameter;
+    return header;
+}
+
+std::string layout_path(const std::string &cache_dir, const LayoutHeader &header) {
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << header.key
+         << (header.data == LayoutData::DistanceFields ? ".fields" : ".clusters");
+    return (fs::path(cache_dir) / name.str()).string();
+}
+
+std::shared_ptr<const MappedFile>
+map_layout(const std::string &path, const LayoutHeader &expected, std::string_view layout) {
+    auto file = std::make_shared<const MappedFile>(path, MappedFile::Access::Random);
+    const auto contents = file->contents();
+    if (!file->opened() || contents.size() < sizeof(LayoutHeader)) {
+        return nullptr;
+    }
+    LayoutHeader header{};
+    std::memcpy(&header, contents.data(), sizeof(header));
+    if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 || header.version != expected.version
+        || header.data != expected.data || header.key != expected.key || header.width != expected.width
+        || header.height != expected.height || header.parameter != expected.parameter
+        || header.layout_size != layout.size() || contents.size() - sizeof(LayoutHeader) < layout.size()
+        || header.size != contents.size() - sizeof(LayoutHeader) - layout.size()
+        || contents.substr(sizeof(LayoutHeader), layout.size()) != layout) {
+        return nullptr;
+    }
+    return file;
+}
+
+std::string_view layout_data(const MappedFile &file) {
+    // mappings start on a page and the header and layout are multiples of 8 bytes long, so the data is aligned
+    LayoutHeader header{};
+    std::memcpy(&header, file.contents().data(), sizeof(header));
+    return file.contents().substr(sizeof(LayoutHeader) + header.layout_size);
+}
+
+bool write_layout(const std::string &path, LayoutHeader header, std::string_view layout, std::string_view data) {
+    header.layout_size = static_cast<uint32_t>(layout.size());
+    header.size = data.size();
+    std::error_code error;
+    fs::create_directories(fs::path(path).parent_path(), error);
+    // unique per process and thread, batch runs may write the same layout from several threads
+    const auto temp_path = path + "." + std::to_string(getpid()) + "."
+                           + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(layout.data(), static_cast<std::streamsize>(layout.size()));
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            std::cout << "Layout cache: cannot write " << temp_path << "\n";
+            fs::remove(temp_path, error);
+            return false;
+        }
+    }
+    fs::rename(temp_path, path, error);
+    if (error) {
+        std::cout << "Layout cache: cannot write " << path << ": " << error.message() << "\n";
+        fs::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,83 @@
+#ifndef MAPF_LAYOUT_CACHE_H
+#define MAPF_LAYOUT_CACHE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "input_parsing.h"
+#include "mapped_file.h"
+
+/* Cache of preprocessed warehouse layouts on disk, so only the first run on a layout pays for preprocessing.
+ *
+ * Every layout gets files of its own in the cache directory, named after the key of its walls, shelves and chargers,
+ * one per kind of data. Robots and packages aren't part of the key, they change none of it. A file is a LayoutHeader,
+ * the layout it was made for (see layout_contents) and the data exactly as it is held in memory, in the byte order of
+ * the machine. A warm run maps the file read only, compares the layout and uses the data right where it is, nothing
+ * else is read or converted up front.
+ *
+ * Files of another version or of another layout under the same name, the key is only a hash, are ignored and written
+ * anew. Bump
+ * layout_cache_version whenever any of the stored data or the order it is stored in changes.
+ */
+constexpr uint32_t layout_cache_version{3};
+
+enum class LayoutData : uint32_t {
+    DistanceFields, // the fields of a DistanceTable
+    ClusterGraph    // the graph of hierarchical planning, see ClusterGraph
+};
+
+struct LayoutHeader {
+    char magic[8];
+    uint32_t version;
+    LayoutData data;
+    uint64_t key;
+    int32_t width;
+    int32_t height;
+    uint32_t parameter; // the number of distance fields, or the cluster size
+    uint32_t layout_size; // bytes of the layout following the header
+    uint64_t size; // bytes of data following the layout
+};
+
+/*
+ * @return a hash of the size, walls, shelves and chargers of inst, in the order they are listed in
+ */
+uint64_t layout_key(const Instance &inst);
+
+/*
+ * @return the size, walls, shelves and chargers of inst as they are stored in the layout files, padded to 8 bytes
+ */
+std::string layout_contents(const Instance &inst);
+
+/*
+ * @return the header of the current version for data of inst, size is left at 0
+ */
+LayoutHeader make_layout_header(const Instance &inst, LayoutData data, uint32_t parameter);
+
+/*
+ * @return the file of header in cache_dir
+ */
+std::string layout_path(const std::string &cache_dir, const LayoutHeader &header);
+
+/*
+ * Maps the layout file at path if it has the version, data, key, size and parameter of expected, is complete and has
+ * been made for layout, see layout_contents.
+ * @return nullptr if there is no such file
+ */
+std::shared_ptr<const MappedFile>
+map_layout(const std::string &path, const LayoutHeader &expected, std::string_view layout);
+
+/*
+ * @return the data following the layout of a file map_layout accepted, aligned for 8 byte values
+ */
+std::string_view layout_data(const MappedFile &file);
+
+/*
+ * Writes header, layout and data to path, creating the directory if needed. The file is written under another name first and
+ * renamed, so concurrent runs on the same layout never map half a file.
+ * @return false if it couldn't be written, the reason has been printed already
+ */
+bool write_layout(const std::string &path, LayoutHeader header, std::string_view layout, std::string_view data);
+
+#endif //MAPF_LAYOUT_CACHE_H
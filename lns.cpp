@@ -0,0 +1,283 @@
+#include "lns.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+#include "delivery_planning.h"
+#include "distance_table.h"
+#include "reservation_table.h"
+#include "search_context.h"
+#include "stats.h"
+
+namespace {
+    // robots planned again per round, drawn anew every round
+    constexpr size_t min_neighbourhood{2};
+    constexpr size_t max_neighbourhood{8};
+
+    enum class Neighbourhood {
+        Random, // any robots
+        Latest, // the robot that is done last, and those that came closest to it on its way
+        Area    // the robots closest to a random place at a random time
+    };
+
+    /*
+     * @return the first length + 1 points of a robot that starts at start and acts as in moves
+     */
+    std::vector<SpaceTimePoint> walk(SpaceTimePoint start, const std::string &moves, size_t length) {
+        std::vector<SpaceTimePoint> points{start};
+        for (size_t k{0}; k < length; ++k) {
+            auto p = points.back();
+            switch (moves[k]) {
+                case 'U':
+                    --p.y;
+                    break;
+                case 'D':
+                    ++p.y;
+                    break;
+                case 'L':
+                    --p.x;
+                    break;
+                case 'R':
+                    ++p.x;
+                    break;
+                default:
+                    break;
+            }
+            ++p.t;
+            points.push_back(p);
+        }
+        return points;
+    }
+
+    int32_t manhattan(SpaceTimePoint p1, SpaceTimePoint p2) {
+        return std::abs(p1.x - p2.x) + std::abs(p1.y - p2.y);
+    }
+
+    /*
+     * @return the k robots of candidates with the smallest distance
+     */
+    std::vector<size_t> closest(std::vector<size_t> candidates, const std::vector<int32_t> &distance, size_t k) {
+        std::stable_sort(candidates.begin(), candidates.end(), [&distance](size_t r1, size_t r2) {
+            return distance[r1] < distance[r2];
+        });
+        candidates.resize(k);
+        return candidates;
+    }
+
+    /*
+     * @param positions per robot its point at every time step of the solution
+     * @param candidates robots with at least one delivery, shuffled
+     */
+    std::vector<size_t> choose_neighbourhood(Neighbourhood kind,
+                                             const std::vector<std::vector<SpaceTimePoint>> &positions,
+                                             const Routes &routes, const std::vector<size_t> &candidates,
+                                             std::mt19937 &rng) {
+        const auto k = std::min(candidates.size(), std::uniform_int_distribution<size_t>(
+                min_neighbourhood, max_neighbourhood)(rng));
+        std::vector<int32_t> distance(routes.size(), 0);
+        switch (kind) {
+            case Neighbourhood::Random:
+                return {candidates.begin(), candidates.begin() + static_cast<std::ptrdiff_t>(k)};
+            case Neighbourhood::Latest: {
+                const auto latest = *std::max_element(candidates.begin(), candidates.end(), [&routes](size_t r1,
+                                                                                                     size_t r2) {
+                    return routes[r1].end.endpoint.t < routes[r2].end.endpoint.t;
+                });
+                const auto &path = positions[latest];
+                for (const auto r : candidates) {
+                    distance[r] = r == latest ? -1 : INT32_MAX;
+                    for (size_t t{0}; r != latest && t < path.size(); ++t) {
+                        distance[r] = std::min(distance[r], manhattan(path[t], positions[r][t]));
+                    }
+                }
+                return closest(candidates, distance, k);
+            }
+            case Neighbourhood::Area: {
+                const auto &path = positions[candidates.front()];
+                const auto t = std::uniform_int_distribution<size_t>(0, path.size() - 1)(rng);
+                for (const auto r : candidates) {
+                    distance[r] = manhattan(path[t], positions[r][t]);
+                }
+                return closest(candidates, distance, k);
+            }
+        }
+        return {};
+    }
+
+    int64_t sum_of_costs(const Routes &routes) {
+        int64_t sum{0};
+        for (const auto &r : routes) {
+            sum += r.end.endpoint.t;
+        }
+        return sum;
+    }
+
+    int32_t latest_end(const Routes &routes) {
+        int32_t latest{0};
+        for (const auto &r : routes) {
+            latest = std::max(latest, r.end.endpoint.t);
+        }
+        return latest;
+    }
+}
+
+bool improve_solution(const Instance &inst, const DistanceTable &distances, const Options &options, Routes &routes,
+                      MoveStrings &move_strings) {
+    if (!(options.improve_time > 0.0) || routes.size() != move_strings.size()) {
+        return false;
+    }
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options.improve_time));
+
+    std::vector<DeliveryTask> tasks;
+    for (const auto &d : inst.deliveries) {
+        tasks.push_back(make_delivery_task(d, inst, distances));
+    }
+    const PathPlanner plan_path = select_planner(options.planner);
+    std::mt19937 rng{std::random_device{}()};
+
+    std::vector<size_t> candidates;
+    for (size_t r{0}; r < routes.size(); ++r) {
+        if (!routes[r].deliveries.empty()) {
+            candidates.push_back(r);
+        }
+    }
+    if (candidates.empty()) {
+        return false;
+    }
+
+    const auto start_of = [&inst](size_t r) {
+        return SpaceTimePoint(inst.robot_positions[r].second);
+    };
+    const auto work_of = [&](size_t r) {
+        return walk(start_of(r), move_strings[r].second, static_cast<size_t>(routes[r].end.endpoint.t));
+    };
+    std::vector<std::vector<SpaceTimePoint>> positions(routes.size());
+    const auto update_positions = [&]() {
+        for (size_t r{0}; r < routes.size(); ++r) {
+            positions[r] = walk(start_of(r), move_strings[r].second, move_strings[r].second.size());
+        }
+    };
+    update_positions();
+
+    // Between rounds the table holds what every robot does up to the end of its last delivery. The moves that keep
+    // robots out of the way afterwards depend on the makespan, they are found again for every new solution.
+    ReservationTable reservations(distances.grid());
+    for (size_t r{0}; r < routes.size(); ++r) {
+        for (const auto p : work_of(r)) {
+            reservations.reserve(p);
+        }
+    }
+
+    const auto initial_makespan = makespan(move_strings);
+    const auto initial_cost = sum_of_costs(routes);
+    size_t rounds{0};
+    size_t kept{0};
+    while (Clock::now() < deadline) {
+        std::shuffle(candidates.begin(), candidates.end(), rng);
+        const auto kind = static_cast<Neighbourhood>(rounds++ % 3);
+        auto chosen = choose_neighbourhood(kind, positions, routes, candidates, rng);
+        std::shuffle(chosen.begin(), chosen.end(), rng);
+
+        for (const auto r : chosen) {
+            for (const auto p : work_of(r)) {
+                reservations.release(p);
+            }
+        }
+
+        // Plan the chosen robots again one after another, each around all others
+        auto new_routes = routes;
+        std::vector<std::string> new_work(routes.size());
+        size_t planned{0};
+        for (const auto r : chosen) {
+            const RobotState robot{inst.robot_positions[r].first, inst.charge, start_of(r)};
+            std::vector<const DeliveryTask *> route_tasks;
+            for (const auto d : routes[r].deliveries) {
+                route_tasks.push_back(&tasks[d]);
+            }
+            std::vector<DeliveryPlan> plans;
+            if (!plan_route(robot, route_tasks, inst, distances, reservations, plan_path, default_search_context(),
+                            plans)) {
+                break;
+            }
+            for (const auto &plan : plans) {
+                new_work[r] += delivery_to_string(plan);
+            }
+            new_routes[r].end = {robot.id, plans.back().charge, plans.back().endpoint};
+            for (const auto p : walk(robot.endpoint, new_work[r], new_work[r].size())) {
+                reservations.reserve(p);
+            }
+            ++planned;
+        }
+
+        const auto new_makespan = latest_end(new_routes);
+        const auto new_cost = sum_of_costs(new_routes);
+        auto better = planned == chosen.size() && (static_cast<size_t>(new_makespan) < makespan(move_strings) || (
+                static_cast<size_t>(new_makespan) == makespan(move_strings) && new_cost < sum_of_costs(routes)));
+
+        // Keep the robots that are done early out of the way, the same as the solver does
+        MoveStrings candidate = move_strings;
+        std::vector<SpaceTimePoint> idle_points;
+        if (better) {
+            std::vector<size_t> order(routes.size());
+            std::iota(order.begin(), order.end(), size_t{0});
+            std::stable_sort(order.begin(), order.end(), [&new_routes](size_t r1, size_t r2) {
+                return new_routes[r1].end.endpoint.t < new_routes[r2].end.endpoint.t;
+            });
+            for (const auto r : order) {
+                auto &moves = candidate[r].second;
+                const auto end = new_routes[r].end;
+                moves = new_work[r].empty() ? moves.substr(0, static_cast<size_t>(end.endpoint.t)) : new_work[r];
+                if (end.endpoint.t == new_makespan) {
+                    continue;
+                }
+                CompactPath rest_path;
+                if (!find_actions(end.endpoint, end.charge, new_makespan - end.endpoint.t - 1, reservations, rng,
+                                  rest_path)) {
+                    better = false;
+                    break;
+                }
+                // the first point is the end of the robot's own work
+                for (const auto p : rest_path) {
+                    if (p.t > end.endpoint.t) {
+                        reservations.reserve(p);
+                        idle_points.push_back(p);
+                    }
+                }
+                rest_path.append_actions(moves);
+            }
+        }
+        for (const auto p : idle_points) {
+            reservations.release(p);
+        }
+
+        if (better) {
+            routes.swap(new_routes);
+            move_strings.swap(candidate);
+            update_positions();
+            ++kept;
+        } else {
+            for (size_t k{0}; k < planned; ++k) {
+                const auto r = chosen[k];
+                for (const auto p : walk(start_of(r), new_work[r], new_work[r].size())) {
+                    reservations.release(p);
+                }
+            }
+            for (const auto r : chosen) {
+                for (const auto p : work_of(r)) {
+                    reservations.reserve(p);
+                }
+            }
+        }
+    }
+
+    std::cout << "Improvement: " << kept << " of " << rounds << " neighbourhoods kept, makespan " << initial_makespan
+              << " -> " << makespan(move_strings) << ", sum of costs " << initial_cost << " -> "
+              << sum_of_costs(routes) << "\n";
+    return kept > 0;
+}
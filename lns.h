@@ -0,0 +1,21 @@
+#ifndef MAPF_LNS_H
+#define MAPF_LNS_H
+
+#include "input_parsing.h"
+#include "options.h"
+#include "solver.h"
+
+class DistanceTable;
+
+/*
+ * Large neighbourhood search on a solution of the prioritized solver, until options.improve_time has passed. Every
+ * round takes the routes of a few robots out of the reservations, chosen at random, around the robot that is done
+ * last, or around a random place on the grid, and plans their deliveries again around everybody else. The new routes
+ * are kept if the makespan gets shorter, or stays the same while the sum of the times the robots are done gets
+ * smaller.
+ * @return true iff the solution was improved, move_strings and routes then hold the better one
+ */
+bool improve_solution(const Instance &inst, const DistanceTable &distances, const Options &options, Routes &routes,
+                      MoveStrings &move_strings);
+
+#endif //MAPF_LNS_H
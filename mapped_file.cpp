@@ -0,0 +1,45 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string &filename, Access access) : m_data{nullptr}, m_size{0}, m_opened{false} {
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return;
+    }
+    if (st.st_size == 0) {
+        m_opened = true; // empty, nothing to map
+    } else {
+        void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            madvise(data, static_cast<size_t>(st.st_size),
+                    access == Access::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+            m_data = static_cast<const char *>(data);
+            m_size = static_cast<size_t>(st.st_size);
+            m_opened = true;
+        }
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (m_data) {
+        munmap(const_cast<char *>(m_data), m_size);
+    }
+}
+
+bool MappedFile::opened() const noexcept {
+    return m_opened;
+}
+
+std::string_view MappedFile::contents() const noexcept {
+    return {m_data, m_size};
+}
@@ -0,0 +1,39 @@
+#ifndef MAPF_MAPPED_FILE_H
+#define MAPF_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/* A whole file mapped read only into memory, unmapped again on destruction.
+ */
+class MappedFile {
+public:
+    // how the contents will be read, passed on to the kernel for read ahead
+    enum class Access {
+        Sequential,
+        Random
+    };
+
+    explicit MappedFile(const std::string &filename, Access access = Access::Sequential);
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /*
+     * @return false if the file couldn't be opened or mapped, an empty file is opened with empty contents
+     */
+    bool opened() const noexcept;
+
+    std::string_view contents() const noexcept;
+
+private:
+    const char *m_data;
+    size_t m_size;
+    bool m_opened;
+};
+
+#endif //MAPF_MAPPED_FILE_H
@@ -0,0 +1,235 @@
+#include "options.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+bool parse_options(int argc, char *argv[], Options &options) {
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<std::string> positional;
+    for (int i{1}; i < argc; ++i) {
+        const std::string arg{argv[i]};
+        if (arg == "--planner") {
+            if (i + 1 == argc) {
+                std::cout << "--planner needs a value\n";
+                return false;
+            }
+            const std::string value{argv[++i]};
+            if (value == "astar") {
+                options.planner = PlannerKind::AStar;
+            } else if (value == "sipp") {
+                options.planner = PlannerKind::Sipp;
+            } else if (value == "hpa") {
+                options.planner = PlannerKind::Hierarchical;
+            } else {
+                std::cout << "Unknown planner: " << value << "\n";
+                return false;
+            }
+        } else if (arg == "--output-format") {
+            if (i + 1 == argc) {
+                std::cout << "--output-format needs a value\n";
+                return false;
+            }
+            const std::string value{argv[++i]};
+            if (value == "text") {
+                options.output_format = OutputFormat::Text;
+            } else if (value == "binary") {
+                options.output_format = OutputFormat::Binary;
+            } else {
+                std::cout << "Unknown output format: " << value << "\n";
+                return false;
+            }
+        } else if (arg == "--allocation") {
+            if (i + 1 == argc) {
+                std::cout << "--allocation needs a value\n";
+                return false;
+            }
+            const std::string value{argv[++i]};
+            if (value == "greedy") {
+                options.allocation = AllocationKind::Greedy;
+            } else if (value == "auction") {
+                options.allocation = AllocationKind::Auction;
+            } else if (value == "hungarian") {
+                options.allocation = AllocationKind::Hungarian;
+            } else {
+                std::cout << "Unknown allocation: " << value << "\n";
+                return false;
+            }
+        } else if (arg == "--solver") {
+            if (i + 1 == argc) {
+                std::cout << "--solver needs a value\n";
+                return false;
+            }
+            const std::string value{argv[++i]};
+            if (value == "greedy") {
+                options.solver = SolverKind::Greedy;
+            } else if (value == "cbs") {
+                options.solver = SolverKind::Cbs;
+            } else if (value == "portfolio") {
+                options.solver = SolverKind::Portfolio;
+            } else if (value == "windowed") {
+                options.solver = SolverKind::Windowed;
+            } else {
+                std::cout << "Unknown solver: " << value << "\n";
+                return false;
+            }
+        } else if (arg == "--time-limit") {
+            if (i + 1 == argc) {
+                std::cout << "--time-limit needs a value\n";
+                return false;
+            }
+            const auto time_limit = std::atof(argv[++i]);
+            if (!(time_limit > 0.0)) {
+                std::cout << "--time-limit needs to be positive\n";
+                return false;
+            }
+            options.time_limit = time_limit;
+        } else if (arg == "--suboptimality") {
+            if (i + 1 == argc) {
+                std::cout << "--suboptimality needs a value\n";
+                return false;
+            }
+            const auto suboptimality = std::atof(argv[++i]);
+            if (!(suboptimality >= 1.0)) {
+                std::cout << "--suboptimality needs to be at least 1\n";
+                return false;
+            }
+            options.suboptimality = suboptimality;
+        } else if (arg == "--stream") {
+            if (i + 1 == argc) {
+                std::cout << "--stream needs a value\n";
+                return false;
+            }
+            options.stream = argv[++i];
+        } else if (arg == "--step-ms") {
+            if (i + 1 == argc) {
+                std::cout << "--step-ms needs a value\n";
+                return false;
+            }
+            const auto step_ms = std::atoi(argv[++i]);
+            if (step_ms < 1) {
+                std::cout << "--step-ms needs to be at least 1\n";
+                return false;
+            }
+            options.step_ms = step_ms;
+        } else if (arg == "--window") {
+            if (i + 1 == argc) {
+                std::cout << "--window needs a value\n";
+                return false;
+            }
+            const auto window = std::atoi(argv[++i]);
+            if (window < 1) {
+                std::cout << "--window needs to be at least 1\n";
+                return false;
+            }
+            options.window = window;
+        } else if (arg == "--improve") {
+            if (i + 1 == argc) {
+                std::cout << "--improve needs a value\n";
+                return false;
+            }
+            const auto improve_time = std::atof(argv[++i]);
+            if (!(improve_time >= 0.0)) {
+                std::cout << "--improve needs to be at least 0\n";
+                return false;
+            }
+            options.improve_time = improve_time;
+        } else if (arg == "--portfolio-size") {
+            if (i + 1 == argc) {
+                std::cout << "--portfolio-size needs a value\n";
+                return false;
+            }
+            const auto portfolio_size = std::atoi(argv[++i]);
+            if (portfolio_size < 1) {
+                std::cout << "--portfolio-size needs to be at least 1\n";
+                return false;
+            }
+            options.portfolio_size = static_cast<size_t>(portfolio_size);
+        } else if (arg == "--batch") {
+            options.batch = true;
+        } else if (arg == "--stats") {
+            if (i + 1 == argc) {
+                std::cout << "--stats needs a value\n";
+                return false;
+            }
+            options.stats_file = argv[++i];
+        } else if (arg == "--layout-cache") {
+            if (i + 1 == argc) {
+                std::cout << "--layout-cache needs a value\n";
+                return false;
+            }
+            options.layout_cache = argv[++i];
+        } else if (arg == "--field-memory") {
+            if (i + 1 == argc) {
+                std::cout << "--field-memory needs a value\n";
+                return false;
+            }
+            const auto mebibytes = std::atoi(argv[++i]);
+            if (mebibytes < 0) {
+                std::cout << "--field-memory can't be negative\n";
+                return false;
+            }
+            options.field_memory = static_cast<size_t>(mebibytes) << 20u;
+        } else if (arg == "--threads") {
+            if (i + 1 == argc) {
+                std::cout << "--threads needs a value\n";
+                return false;
+            }
+            const auto threads = std::atoi(argv[++i]);
+            if (threads < 1) {
+                std::cout << "--threads needs to be at least 1\n";
+                return false;
+            }
+            options.threads = static_cast<size_t>(threads);
+        } else if (arg.find("--") == 0) {
+            std::cout << "Unknown option: " << arg << "\n";
+            return false;
+        } else {
+            positional.push_back(arg);
+        }
+    }
+
+    if (positional.size() != 2) {
+        return false;
+    }
+    options.input_file = positional[0];
+    options.output_file = positional[1];
+    return true;
+}
+
+void print_usage() {
+    std::cout << "Invalid program call. Call as './mapf [options] <input file> <output file>\n";
+    std::cout << "Options:\n";
+    std::cout << "\t--planner astar|sipp|hpa\tlow level path planner, hpa plans long legs on a graph of clusters\n"
+                 "\t\t\t\tof the grid first, default astar\n";
+    std::cout << "\t--allocation greedy|auction|hungarian\n"
+                 "\t\t\t\thow deliveries are assigned to robots, default greedy (file order)\n";
+    std::cout << "\t--solver greedy|cbs|portfolio|windowed\n"
+                 "\t\t\t\tgreedy prioritized planning, conflict based search, several greedy solves with\n"
+                 "\t\t\t\tdifferent orderings in parallel keeping the best, or planning only a window of\n"
+                 "\t\t\t\ttime steps ahead (WHCA*), default greedy\n";
+    std::cout << "\t--window <steps>\ttime steps the windowed solver plans ahead, smaller is faster but finds\n"
+                 "\t\t\t\tworse solutions, default 16\n";
+    std::cout << "\t--time-limit <seconds>\tsearch time of the cbs solver before it falls back to greedy, or time\n"
+                 "\t\t\t\tafter which the portfolio takes the best solution so far, default 10\n";
+    std::cout << "\t--portfolio-size <n>\tnumber of solves of the portfolio, default one per thread\n";
+    std::cout << "\t--improve <seconds>\tkeep replanning the routes of a few robots at a time to shorten a greedy or\n"
+                 "\t\t\t\tportfolio solution (large neighbourhood search), default 0\n";
+    std::cout << "\t--suboptimality <w>\tlet cbs expand nodes with fewer conflicts first as long as their makespan is\n"
+                 "\t\t\t\twithin w times the best one (ECBS), default 1\n";
+    std::cout << "\t--stream <file>|-\tlifelong mode, keep reading deliveries from a file, FIFO or stdin and\n"
+                 "\t\t\t\twrite the output while they arrive\n";
+    std::cout << "\t--step-ms <ms>\t\twall clock length of a time step in stream mode, default 100\n";
+    std::cout << "\t--output-format text|binary\tone char per robot and step, or 3 bits packed, default text\n";
+    std::cout << "\t--batch\t\t\tthe input is a directory or a manifest of instances and the output a directory,\n"
+                 "\t\t\t\tthe instances are solved on all threads and summed up in summary.csv there\n";
+    std::cout << "\t--stats <file>\t\twrite search counters and phase timings as JSON\n";
+    std::cout << "\t--layout-cache <dir>\tkeep the distance fields of every warehouse layout here, runs on a layout\n"
+                 "\t\t\t\tthat has been seen before map them instead of computing them\n";
+    std::cout << "\t--field-memory <MiB>\tmemory of the distance fields towards shelves and chargers, targets\n"
+                 "\t\t\t\twithout one use the manhattan distance, default 256\n";
+    std::cout << "\t--threads <n>\t\tthreads to evaluate candidate robots with, default all cores\n";
+}
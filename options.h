@@ -0,0 +1,52 @@
+#ifndef MAPF_OPTIONS_H
+#define MAPF_OPTIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "distance_table.h"
+#include "solution_writer.h"
+#include "task_allocation.h"
+
+enum class PlannerKind {
+    AStar, Sipp, Hierarchical
+};
+
+enum class SolverKind {
+    Greedy, // prioritized planning, one delivery after another
+    Cbs,    // conflict based search over complete robot routes, falls back to Greedy on timeout
+    Portfolio, // several Greedy solves with different orderings in parallel, the best one is kept
+    Windowed   // robots plan only a window of time steps ahead and replan as time advances (WHCA*)
+};
+
+struct Options {
+    std::string input_file;
+    std::string output_file;
+    OutputFormat output_format{OutputFormat::Text};
+    PlannerKind planner{PlannerKind::AStar};
+    AllocationKind allocation{AllocationKind::Greedy};
+    SolverKind solver{SolverKind::Greedy};
+    double time_limit{10.0}; // seconds the cbs solver may search before falling back, or the portfolio may run
+    int32_t window{16}; // time steps the windowed solver plans ahead, it replans after half of them
+    double suboptimality{1.0}; // makespan bound of the cbs solver relative to the best open node
+    bool batch{false}; // input_file is a directory or manifest of instances and output_file a directory, see run_batch
+    std::string stream; // stream mode reads further deliveries from here ("-" for stdin), empty if off
+    int32_t step_ms{100}; // wall clock length of a time step in stream mode
+    std::string stats_file; // counters and timers of the run are written here as JSON, empty if off
+    std::string layout_cache; // directory of preprocessed layouts, see layout_cache.h, empty if off
+    size_t field_memory{DistanceTable::default_field_memory}; // bytes the distance fields may take
+    double improve_time{0.0}; // seconds the solution is improved by large neighbourhood search, 0 for none
+    size_t portfolio_size{0}; // number of solves of the portfolio, 0 for one per thread
+    size_t threads{1}; // threads used to evaluate candidate robots, parse_options defaults it to the number of cores
+};
+
+/*
+ * Reads the command line, './mapf [options] <input file> <output file>'.
+ * @return false if the call is invalid, the reason has been printed already
+ */
+bool parse_options(int argc, char *argv[], Options &options);
+
+void print_usage();
+
+#endif //MAPF_OPTIONS_H
@@ -3,9 +3,14 @@
 //
 
 #include "pathfinding.h"
+#include "compact_path.h"
+#include "distance_table.h"
+#include "reservation_table.h"
+#include "search_context.h"
+#include "search_policies.h"
+#include "stats.h"
 
 #include <algorithm>
-#include <queue>
 #include <iostream>
 
 SpacePoint::SpacePoint(SpaceTimePoint p) {
@@ -32,6 +37,8 @@ std::ostream &operator<<(std::ostream &os, const SpacePoint p) {
     return os;
 }
 
+SpaceTimePoint::SpaceTimePoint() : x{0}, y{0}, t{0} {}
+
 SpaceTimePoint::SpaceTimePoint(SpacePoint p, int32_t t) {
     this->x = p.x;
     this->y = p.y;
@@ -55,137 +62,324 @@ bool SpaceTimePoint::operator==(const SpaceTimePoint other) const {
            && this->t == other.t;
 }
 
-std::vector<SpaceTimePoint> get_neighbours(SpaceTimePoint p, int32_t width, int32_t height,
-                                           const std::unordered_set<SpaceTimePoint> &reservations) {
-    std::vector<SpaceTimePoint> neighbours;
-    neighbours.emplace_back(p.x, p.y, p.t + 1);
-    if (p.x > 0) {
-        neighbours.emplace_back(p.x - 1, p.y, p.t + 1);
-    }
-    if (p.x < width - 1) {
-        neighbours.emplace_back(p.x + 1, p.y, p.t + 1);
-    }
-    if (p.y > 0) {
-        neighbours.emplace_back(p.x, p.y - 1, p.t + 1);
-    }
-    if (p.y < height - 1) {
-        neighbours.emplace_back(p.x, p.y + 1, p.t + 1);
+namespace {
+    /*
+     * @return true iff a robot arriving at p may stay there for rest more steps
+     */
+    template<typename Reservations>
+    bool can_rest(SpaceTimePoint p, int32_t rest, const Reservations &reservations) {
+        return rest <= 0 || reservations.next_blocked(p.x, p.y, p.t + 1) > p.t + rest;
     }
 
-    std::vector<SpaceTimePoint> valid_neighbours;
-    for (const auto n : neighbours) {
-        if (reservations.empty()
-            || (reservations.find(n) == reservations.end()
-                && reservations.find(SpaceTimePoint(n.x, n.y, n.t - 1)) ==
-                   reservations.end()  // we must not train someone else
-                && reservations.find(SpaceTimePoint(n.x, n.y, n.t + 1)) ==
-                   reservations.end())) // we must not force someone else into training us
-        {
-            valid_neighbours.push_back(n);
+    // a_star gives up once a robot would be on its way heuristic_factor times as long as without anybody in the way
+    constexpr int32_t heuristic_factor{20};
+
+    /*
+     * The search of a_star, put together from the policies of search_policies.h. The reservations are only asked
+     * whether the goal stays free for the rest, see can_rest.
+     */
+    template<typename Heuristic, typename Neighbourhood, typename Energy, typename Reservations>
+    CompactPath a_star_kernel(SpaceTimePoint start, SpacePoint goal, uint32_t rest_after, int32_t charge,
+                              const Heuristic &h, const Neighbourhood &neighbours_of, const Energy &energy,
+                              const Reservations &reservations, SearchContext &context) {
+        context.reset();
+        SearchRecorder recorder(context);
+        context.push_open(context.add(start, -1, charge), h(start) + start.t, h(start));
+
+        // If we don't manage to move away from the start or spend >= 4/5ths of the time waiting, give up
+        const auto heuristic_distance = static_cast<int32_t>(h(start));
+
+        while (!context.open_empty()) {
+            const auto curr_id = context.pop_open();
+            const auto curr = context.node(curr_id);
+
+            if (SpacePoint(curr.p) == goal) {
+                recorder.found = true;
+                return reconstruct_path(context, curr_id); // use curr to ensure we know the time
+            }
+
+            ++recorder.expanded;
+            const auto valid_neighbours = neighbours_of(curr.p);
+            recorder.lookups += valid_neighbours.checked;
+            for (const auto n : valid_neighbours) {
+                // Normally we check the cost so far, our cost so far is always the same. So we check the seen nodes
+                // instead, as any seen (even not explored) node has an entry
+                const int32_t new_charge = energy.after(curr.charge, n.x != curr.p.x || n.y != curr.p.y);
+                if (!energy.allows(n, new_charge)) {
+                    continue;
+                }
+
+                if ((n.t - start.t) >= (heuristic_factor * heuristic_distance)) { // we are staying still...
+                    recorder.cut_off = true;
+                    return CompactPath{};
+                }
+
+                if (context.find(n) < 0) {
+                    if (SpacePoint(n) == goal) { // check if the goal is free for the additional rest period
+                        ++recorder.lookups;
+                        if (can_rest(n, static_cast<int32_t>(rest_after), reservations)) {
+                            context.push_open(context.add(n, curr_id, new_charge), h(n) + n.t, h(n));
+                        }
+                    } else {
+                        context.push_open(context.add(n, curr_id, new_charge), h(n) + n.t, h(n));
+                    }
+                }
+            }
         }
+
+        return CompactPath{};
     }
-    return valid_neighbours;
 }
 
-std::vector<SpaceTimePoint>
-reconstruct_path(const std::unordered_map<SpaceTimePoint, SpaceTimePoint> &came_from, SpaceTimePoint goal) {
-    std::vector<SpaceTimePoint> path;
-    SpaceTimePoint curr = goal;
-    path.push_back(curr);
-    while (came_from.find(curr) != came_from.end()) {
-        curr = came_from.at(curr);
-        path.push_back(curr);
+Neighbours get_neighbours(SpaceTimePoint p, const ReservationTable &reservations) {
+    return GridNeighbourhood<ReservationTable>(reservations)(p);
+}
+
+CompactPath reconstruct_path(const SearchContext &context, int32_t goal_id) {
+    auto start_id = goal_id;
+    size_t moves{0};
+    for (; context.node(start_id).parent >= 0; start_id = context.node(start_id).parent) {
+        ++moves;
+    }
+
+    // fill in the moves from the back, following the parents
+    CompactPath path(context.node(start_id).p, moves);
+    for (auto id = goal_id; id != start_id; id = context.node(id).parent) {
+        const auto &node = context.node(id);
+        path.set_move(--moves, move_between(context.node(node.parent).p, node.p));
     }
-    std::reverse(path.begin(), path.end());
     return path;
 }
 
-std::vector<SpaceTimePoint>
+CompactPath
 a_star(const SpaceTimePoint start, const SpacePoint goal, uint32_t rest_after, int32_t charge, uint32_t width,
-       uint32_t height,
-       const std::unordered_set<SpaceTimePoint> &reservations) { // heuristic is always manhatten distance
+       uint32_t height, const ReservationTable &reservations) {
+    return a_star(start, goal, rest_after, charge, width, height, reservations, nullptr, default_search_context());
+}
+
+CompactPath
+a_star(const SpaceTimePoint start, const SpacePoint goal, uint32_t rest_after, int32_t charge, uint32_t width,
+       uint32_t /*height, the grid of reservations knows the bounds*/, const ReservationTable &reservations,
+       const DistanceTable *distances, SearchContext &context) {
     if (charge < 0) {
-        return std::vector<SpaceTimePoint>{};
+        return CompactPath{};
+    }
+
+    // the true distance if we have a field towards goal, manhatten distance otherwise
+    const uint16_t *goal_field = distances ? distances->field(goal) : nullptr;
+    const GridNeighbourhood<ReservationTable> neighbourhood(reservations);
+    // the search gives up before a robot with that much charge could run out of it
+    const auto unlimited = [charge](uint32_t h_start) {
+        return int64_t{charge} >= int64_t{heuristic_factor} * h_start;
+    };
+    // the policies depend on the goal and charge of this search, so they are picked here, a few compares per search
+    if (goal_field) {
+        const FieldHeuristic h{goal_field, width};
+        if (h(start) == DistanceTable::unreachable) {
+            return CompactPath{};
+        }
+        return unlimited(h(start))
+               ? a_star_kernel(start, goal, rest_after, charge, h, neighbourhood, UnlimitedEnergy{}, reservations,
+                               context)
+               : a_star_kernel(start, goal, rest_after, charge, h, neighbourhood, BatteryEnergy{}, reservations,
+                               context);
     }
+    const ManhattanHeuristic h{goal};
+    return unlimited(h(start))
+           ? a_star_kernel(start, goal, rest_after, charge, h, neighbourhood, UnlimitedEnergy{}, reservations, context)
+           : a_star_kernel(start, goal, rest_after, charge, h, neighbourhood, BatteryEnergy{}, reservations, context);
+}
 
-    using ChargePoint = std::pair<SpaceTimePoint, int32_t>;
-    const auto cmp = [goal](ChargePoint p1, ChargePoint p2) {
-        // in f(p) = g(p) + h(p), manhatten distance is the heuristic and g(p) = p.t
-        const auto d1 = manhatten_distance(p1.first, goal) + p1.first.t;
-        const auto d2 = manhatten_distance(p2.first, goal) + p2.first.t;
-        return d1 > d2 || (d1 == d2 && p1.first.x < p2.first.x); // direct comparison of x, y is used to break ties
+CompactPath
+a_star_to_charger(const SpaceTimePoint start, int32_t charge, int32_t full_charge, const std::vector<int32_t> &tails,
+                  const ReservationTable &reservations, const DistanceTable &distances, SearchContext &context) {
+    const uint16_t *field = distances.charger_field();
+    if (charge < 0 || !field) {
+        return CompactPath{};
+    }
+    const FieldHeuristic to_charger{field, static_cast<size_t>(reservations.grid().width())};
+    if (to_charger(start) == DistanceTable::unreachable) {
+        return CompactPath{};
+    }
+    // waiting at a busy charger is fine for a while, but not forever
+    const auto give_up = int64_t{start.t} + heuristic_factor * std::max<int64_t>(to_charger(start), 1) + full_charge;
+
+    // Per charger the earliest end there: not before the robot could walk there, and not before the charger is free
+    // for the shortest recharge the robot could need then. When all chargers are busy for long, a heuristic without
+    // that would have the search expand every field for every time step until one is free, tails included.
+    struct ChargerEnd {
+        TargetHeuristic distance;
+        int64_t ready;
+        int32_t tail;
+    };
+    std::vector<ChargerEnd> charger_ends;
+    for (size_t k{0}; k < distances.chargers().size(); ++k) {
+        const auto c = distances.chargers()[k];
+        const auto tail = tails.empty() ? 0 : tails[k];
+        const TargetHeuristic to_c{distances.field(c), to_charger.width, c};
+        const auto d = to_c(start);
+        if (tail < 0 || d == DistanceTable::unreachable || static_cast<int32_t>(d) > charge) {
+            continue;
+        }
+        const auto rest = full_charge - (charge - static_cast<int32_t>(d));
+        for (auto t = start.t + static_cast<int32_t>(d); t <= give_up;) {
+            if (t > start.t && !reservations.is_free_around(c.x, c.y, t)) {
+                ++t;
+            } else if (can_rest(SpaceTimePoint(c, t), rest, reservations)) {
+                charger_ends.push_back({to_c, t, tail});
+                break;
+            } else {
+                t = reservations.next_blocked(c.x, c.y, t + 1);
+            }
+        }
+    }
+    if (charger_ends.empty()) {
+        return CompactPath{};
+    }
+    // the least cost of an end reached through p, -1 if there is none
+    const auto cost_bound = [&charger_ends](SpaceTimePoint p) -> int64_t {
+        int64_t bound{-1};
+        for (const auto &end : charger_ends) {
+            const auto d = end.distance(p);
+            if (d == DistanceTable::unreachable) {
+                continue;
+            }
+            const auto cost = std::max(int64_t{p.t} + d, end.ready) + end.tail;
+            if (bound < 0 || cost < bound) {
+                bound = cost;
+            }
+        }
+        return bound;
+    };
+    const auto push = [&](SpaceTimePoint p, int32_t parent, int32_t charge_left, int64_t bound) {
+        context.push_open(context.add(p, parent, charge_left), static_cast<uint32_t>(bound),
+                          static_cast<uint32_t>(bound - p.t));
     };
-    std::priority_queue<ChargePoint, std::vector<ChargePoint>, decltype(cmp)> open_set(cmp);
-    open_set.push(std::make_pair(start, charge));
 
-    std::unordered_map<SpaceTimePoint, SpaceTimePoint> came_from{};
+    const GridNeighbourhood<ReservationTable> neighbours_of(reservations);
+    const BatteryEnergy energy;
+    // the cost of ending at p, -1 if it is not an end
+    const auto end_cost = [&](SpaceTimePoint p, int32_t charge_left) -> int64_t {
+        const auto k = distances.charger_index(SpacePoint(p));
+        if (k < 0 || (!tails.empty() && tails[k] < 0)) {
+            return -1;
+        }
+        if (!can_rest(p, full_charge - charge_left, reservations)) {
+            return -1;
+        }
+        return int64_t{p.t} + (tails.empty() ? 0 : tails[k]);
+    };
 
-    // If we don't manage to move away from the start or spend >= 4/5ths of the time waiting, give up
-    const auto heuristic_distance = static_cast<int32_t>(manhatten_distance(start, goal));
-    const int32_t heuristic_factor = 20;
+    context.reset();
+    SearchRecorder recorder(context);
+    const auto start_bound = cost_bound(start);
+    if (start_bound < 0) {
+        return CompactPath{};
+    }
+    push(start, -1, charge, start_bound);
 
-    while (!open_set.empty()) {
-        const auto curr = open_set.top();
-        open_set.pop();
+    // Ends are not goals in the usual sense, a robot may pass a charger towards a better one. So the best end seen is
+    // kept and returned once no open node can beat it anymore.
+    int32_t best_id{-1};
+    int64_t best_cost{0};
+    while (!context.open_empty()) {
+        const auto curr_id = context.pop_open();
+        const auto curr = context.node(curr_id);
+        if (best_id >= 0 && best_cost <= cost_bound(curr.p)) {
+            break;
+        }
 
-        if (SpacePoint(curr.first) == goal) {
-            const auto path = reconstruct_path(came_from, curr.first); // use curr to ensure we know the time
-            return path;
+        ++recorder.lookups;
+        const auto cost = end_cost(curr.p, curr.charge);
+        if (cost >= 0 && (best_id < 0 || cost < best_cost)) {
+            best_id = curr_id;
+            best_cost = cost;
+        }
+        if (curr.p.t >= give_up) {
+            recorder.cut_off = true;
+            continue;
         }
 
-        const auto valid_neighbours = get_neighbours(curr.first, width, height, reservations);
-        for (const auto n : valid_neighbours) {
-            // Normally we check the cost so far, our cost so far is always the same. So we check came_from instead,
-            // as any seen (even not explored) node has an entry
-            const int32_t new_charge = n.x == curr.first.x && n.y == curr.first.y ? curr.second : curr.second - 1;
-            if (new_charge < 0) {
-                break;
+        ++recorder.expanded;
+        const auto valid_neighbours = neighbours_of(curr.p);
+        recorder.lookups += valid_neighbours.checked;
+        // Staying is pushed last, so of the neighbours that are as good it is tried first: a robot that has to wait
+        // for a charger anyway waits where it is and walks there once it is time, with the most charge left.
+        for (auto k = valid_neighbours.count; k-- > 0;) {
+            const auto n = valid_neighbours.points[k];
+            const int32_t new_charge = energy.after(curr.charge, n.x != curr.p.x || n.y != curr.p.y);
+            if (!energy.allows(n, new_charge) || context.find(n) >= 0) {
+                continue;
+            }
+            const auto bound = cost_bound(n);
+            if (bound >= 0) {
+                push(n, curr_id, new_charge, bound);
             }
+        }
+    }
 
-            if (/*(n.x == start.x && n.y == start.y && n.t - start.t >= heuristic_factor * heuristic_distance) || */
-                    (n.t - start.t) >= (heuristic_factor * heuristic_distance)) { // we are staying still...
-                std::cout << "Quit for heuristic!\n";
-                std::cout << "Heuristic distance: " << heuristic_distance << "\n";
-                std::cout << "n: \t" << n << "\n";
-                std::cout << "start: \t" << start << "\n";
-                return std::vector<SpaceTimePoint>{};
+    if (best_id < 0) {
+        return CompactPath{};
+    }
+    recorder.found = true;
+    return reconstruct_path(context, best_id);
+}
+
+CompactPath
+a_star_windowed(const SpaceTimePoint start, const uint16_t *field, int32_t rest_after, int32_t charge,
+                int32_t full_charge, int32_t window, const ReservationTable &reservations,
+                const DistanceTable &distances, SearchContext &context) {
+    const auto width = static_cast<size_t>(reservations.grid().width());
+    const FieldHeuristic h{field, width};
+    if (charge < 0 || !field || h(start) == DistanceTable::unreachable) {
+        return CompactPath{};
+    }
+    const auto window_end = start.t + std::max(window, 0);
+    const GridNeighbourhood<ReservationTable> neighbours_of(reservations);
+    // wherever the robot is, it has to be able to get to a charger afterwards
+    const ChargerReserveEnergy energy{{distances.charger_field(), width}};
+
+    context.reset();
+    SearchRecorder recorder(context);
+    context.push_open(context.add(start, -1, charge), h(start) + start.t, h(start));
+
+    while (!context.open_empty()) {
+        const auto curr_id = context.pop_open();
+        const auto curr = context.node(curr_id);
+
+        if (h(curr.p) == 0) {
+            const auto rest = rest_after >= 0 ? rest_after : full_charge - curr.charge;
+            ++recorder.lookups;
+            if (can_rest(curr.p, std::min(rest, window_end - curr.p.t), reservations)) {
+                recorder.found = true;
+                return reconstruct_path(context, curr_id);
             }
+        }
+        // beyond the window the distance field takes over
+        if (curr.p.t >= window_end) {
+            recorder.found = true;
+            return reconstruct_path(context, curr_id);
+        }
 
-            if (came_from.empty()) { // no reservations exist
-                came_from.insert(std::make_pair(n, curr.first));
-                open_set.push(std::make_pair(n, new_charge));
-            } else if (came_from.find(n) == came_from.end()) { // no reservations that trouble us
-                if (SpacePoint(n) == goal) { // check if the goal is free for the additional rest period
-                    bool all_available = true;
-                    for (uint32_t i{0}; i <= rest_after + 1; ++i) {
-                        // n.t is already 1 in the
-                        // n.t + k is k + 1 in the future
-                        // if k + 1 in the future are okay with us, we can stay for k and be fine?
-                        if (came_from.find(SpaceTimePoint(n.x, n.y, n.t + i)) != came_from.end()) {
-                            all_available = false;
-                            break;
-                        }
-                    }
-                    if (all_available) {
-                        came_from.insert(std::make_pair(n, curr.first));
-                        open_set.push(std::make_pair(n, new_charge));
-                    }
-                } else {
-                    came_from.insert(std::make_pair(n, curr.first));
-                    open_set.push(std::make_pair(n, new_charge));
-                }
+        ++recorder.expanded;
+        const auto valid_neighbours = neighbours_of(curr.p);
+        recorder.lookups += valid_neighbours.checked;
+        for (const auto n : valid_neighbours) {
+            const int32_t new_charge = energy.after(curr.charge, n.x != curr.p.x || n.y != curr.p.y);
+            if (!energy.allows(n, new_charge) || h(n) == DistanceTable::unreachable || context.find(n) >= 0) {
+                continue;
             }
+            context.push_open(context.add(n, curr_id, new_charge), h(n) + n.t, h(n));
         }
     }
 
-    const std::vector<SpaceTimePoint> path;
-    return path;
+    return CompactPath{};
 }
 
 std::pair<bool, int32_t>
 find_path_and_update(SpaceTimePoint start, SpacePoint goal, uint32_t rest_after, int32_t charge, uint32_t width,
-                     uint32_t height, std::unordered_set<SpaceTimePoint> &reservations) {
-    std::vector<SpaceTimePoint> path;
+                     uint32_t height, ReservationTable &reservations) {
+    CompactPath path;
     if (start.x != goal.x && start.y != goal.y) {
         path = a_star(start, goal, rest_after, charge, width, height, reservations);
         if (path.empty()) {
@@ -193,25 +387,18 @@ find_path_and_update(SpaceTimePoint start, SpacePoint goal, uint32_t rest_after,
         }
     }
     for (const auto p : path) {
-        reservations.insert(p);
+        reservations.reserve(p);
     }
     int32_t used_charge = get_used_charge(path);
     return std::make_pair(true, used_charge);
 }
 
-int32_t get_used_charge(const std::vector<SpaceTimePoint> &path) {
-    if (path.empty()) {
-        return 0;
-    }
-
+int32_t get_used_charge(const CompactPath &path) {
     int32_t charge{0};
-    SpacePoint last{path.at(0)};
-    for (const auto p : path) {
-        SpacePoint curr{p};
-        if (last != curr) {
+    for (size_t k{0}; k < path.moves(); ++k) {
+        if (path.move(k) != Move::Rest) {
             ++charge;
         }
-        last = curr;
     }
     return charge;
 }
@@ -5,10 +5,9 @@
 #ifndef MAPF_PATHFINDING_H
 #define MAPF_PATHFINDING_H
 
+#include <array>
 #include <ostream>
 //#include <queue>
-#include <unordered_set>
-#include <unordered_map>
 #include <vector>
 
 /* Used to implement custom hash functions for own datatypes (SpaceTimePoint specifically)
@@ -26,6 +25,14 @@ inline void hash_combine(std::size_t &seed, const T &v) {
     seed ^= hasher(v) + 0x9e3779b9 + (seed << 6u) + (seed >> 2u);
 }
 
+class CompactPath;
+
+class ReservationTable;
+
+class SearchContext;
+
+class DistanceTable;
+
 enum class Move {
     Up, Down, Left, Right, Rest
 };
@@ -48,6 +55,8 @@ struct SpacePoint {
 };
 
 struct SpaceTimePoint {
+    SpaceTimePoint();
+
     explicit SpaceTimePoint(SpacePoint p, int32_t t = 0);
 
     explicit SpaceTimePoint(int32_t x, int32_t y, int32_t t);
@@ -79,11 +88,25 @@ uint32_t manhatten_distance(P1 p1, P2 p2) {
     return std::abs(p1.x - p2.x) + std::abs(p1.y - p2.y);
 }
 
-std::vector<SpaceTimePoint>
-get_neighbours(SpaceTimePoint p, int32_t width, int32_t height, const std::unordered_set<SpaceTimePoint> &reservations);
+/* Fixed size result of get_neighbours, a point has at most 4 neighbours + itself one step later
+ */
+struct Neighbours {
+    const SpaceTimePoint *begin() const noexcept { return points.data(); }
+
+    const SpaceTimePoint *end() const noexcept { return points.data() + count; }
+
+    std::array<SpaceTimePoint, 5> points;
+    size_t count{0};
+    size_t checked{0}; // reservation lookups it took
+};
+
+/*
+ * @return the fields a robot at p may be on one step later: staying, then left, right, up and down. Grid bounds and
+ * walls come from the neighbour mask of the grid of reservations, only the other robots have to be checked.
+ */
+Neighbours get_neighbours(SpaceTimePoint p, const ReservationTable &reservations);
 
-std::vector<SpaceTimePoint>
-reconstruct_path(const std::unordered_map<SpaceTimePoint, SpaceTimePoint> &came_from, SpaceTimePoint goal);
+CompactPath reconstruct_path(const SearchContext &context, int32_t goal_id);
 
 /**
  * start: the start node
@@ -91,15 +114,68 @@ reconstruct_path(const std::unordered_map<SpaceTimePoint, SpaceTimePoint> &came_
  * 
  * rest_after: number of time units the field needs to stay free after arrival, e.g. for loading, unloading, charging
  * max_charge: the max. number of move actions that are legal to be executed, resting does not take charge
+ *
+ * Uses the search context of the calling thread.
  */
-std::vector<SpaceTimePoint>
+CompactPath
 a_star(SpaceTimePoint start, SpacePoint goal, uint32_t rest_after, int32_t charge, uint32_t width, uint32_t height,
-       const std::unordered_set<SpaceTimePoint> &reservations);
+       const ReservationTable &reservations);
+
+/**
+ * Same as above, but all search buffers are taken from context, which is reset first.
+ *
+ * distances: if it has a field towards goal, that is used as heuristic instead of the manhatten distance. May be null.
+ */
+CompactPath
+a_star(SpaceTimePoint start, SpacePoint goal, uint32_t rest_after, int32_t charge, uint32_t width, uint32_t height,
+       const ReservationTable &reservations, const DistanceTable *distances, SearchContext &context);
+
+/**
+ * Multi goal a_star towards all chargers of distances at once, the way to the charger that is done first.
+ *
+ * A charger only counts if the robot can stay there until it is full again, that is full_charge minus the charge left
+ * on arrival steps. Ends are compared by arrival time + tails[index of the charger], so a charger closer to where the
+ * robot heads next can win over one reached earlier. Chargers with a negative tail are left out, empty tails means
+ * all chargers with tail 0.
+ *
+ * The heuristic is the least end cost over the chargers, each reached no earlier than its field allows and than it is
+ * free for the shortest recharge the robot could need there. All search buffers are taken from context.
+ */
+CompactPath
+a_star_to_charger(SpaceTimePoint start, int32_t charge, int32_t full_charge, const std::vector<int32_t> &tails,
+                  const ReservationTable &reservations, const DistanceTable &distances, SearchContext &context);
+
+/**
+ * Windowed a_star (WHCA*): only the next window time steps are searched against the reservations. The goals are the
+ * fields where field is 0, it is also the heuristic, so a field towards a shelf or towards the nearest charger fits.
+ *
+ * The path ends on a goal if one is reached within the window and the robot can stay there for rest_after steps, or
+ * until the window ends if that comes first. rest_after < 0 means as long as it takes to recharge to full_charge.
+ * Otherwise the path ends at start.t + window with the least distance still to go, the rest of the way is left to
+ * the field, as if nobody was in the way. Every step keeps enough charge to reach a charger.
+ *
+ * All search buffers are taken from context.
+ * @return an empty path if the robot can't even stay where it is
+ */
+CompactPath
+a_star_windowed(SpaceTimePoint start, const uint16_t *field, int32_t rest_after, int32_t charge, int32_t full_charge,
+                int32_t window, const ReservationTable &reservations, const DistanceTable &distances,
+                SearchContext &context);
+
+/**
+ * Signature shared by all low level planners (a_star, sipp), so the solver can be run with any of them.
+ */
+using PathPlanner = CompactPath (*)(SpaceTimePoint start, SpacePoint goal, uint32_t rest_after, int32_t charge,
+                                    uint32_t width, uint32_t height, const ReservationTable &reservations,
+                                    const DistanceTable *distances, SearchContext &context);
 
 std::pair<bool, int32_t>
 find_path_and_update(SpaceTimePoint start, SpacePoint goal, uint32_t rest_after, int32_t charge, uint32_t width,
-                     uint32_t height, std::unordered_set<SpaceTimePoint> &reservations);
+                     uint32_t height, ReservationTable &reservations);
 
-int32_t get_used_charge(const std::vector<SpaceTimePoint> &path);
+/*
+ * @return the number of steps of path that aren't rests
+ */
+int32_t get_used_charge(const CompactPath &path);
 
 #endif //MAPF_PATHFINDING_H
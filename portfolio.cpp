@@ -0,0 +1,108 @@
+#include "portfolio.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+
+#include "thread_pool.h"
+
+namespace {
+    const char *tie_break_name(TieBreak tie_break) {
+        switch (tie_break) {
+            case TieBreak::Stable:
+                return "idle longest";
+            case TieBreak::LowestId:
+                return "lowest id";
+            case TieBreak::MostCharge:
+                return "most charge";
+            case TieBreak::Random:
+                return "random";
+        }
+        return "unknown";
+    }
+
+    SolveVariant make_variant(size_t k, size_t deliveries, uint32_t base_seed) {
+        SolveVariant variant;
+        variant.seed = base_seed + static_cast<uint32_t>(k);
+        variant.tie_break = static_cast<TieBreak>(k % 4);
+        variant.verbose = false;
+        if (k >= 4) {
+            variant.delivery_order.resize(deliveries);
+            std::iota(variant.delivery_order.begin(), variant.delivery_order.end(), size_t{0});
+            std::mt19937 rng{variant.seed};
+            std::shuffle(variant.delivery_order.begin(), variant.delivery_order.end(), rng);
+        }
+        return variant;
+    }
+}
+
+bool solve_portfolio(const Instance &inst, const DistanceTable &distances, const Options &options,
+                     MoveStrings &move_strings, Routes &routes) {
+    const auto solves = options.portfolio_size == 0 ? options.threads : options.portfolio_size;
+    const auto base_seed = std::random_device{}();
+
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double>(options.time_limit));
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> next{0};
+    size_t finished{0};
+    size_t best{solves};
+
+    // every worker solves one variant after the other on its own, with a pool of its own that runs inline
+    const auto work = [&]() {
+        ThreadPool inline_pool(1);
+        MoveStrings candidate;
+        Routes candidate_routes;
+        for (auto k = next++; k < solves && !stop; k = next++) {
+            auto variant = make_variant(k, inst.deliveries.size(), base_seed);
+            variant.stop = &stop;
+            variant.routes = &candidate_routes;
+            const auto solved = solve_prioritized(inst, distances, options, inline_pool, variant, candidate);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (solved && (best == solves || makespan(candidate) < makespan(move_strings))) {
+                best = k;
+                move_strings.swap(candidate);
+                routes.swap(candidate_routes);
+            }
+            ++finished;
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t w{0}; w < std::min(solves, options.threads); ++w) {
+        workers.emplace_back(work);
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait_until(lock, deadline, [&] { return finished == solves; });
+        // past the deadline anything goes, but we still need something
+        changed.wait(lock, [&] { return finished == solves || best != solves; });
+        stop = true;
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+
+    if (best == solves) {
+        std::cout << "Portfolio: none of the " << solves << " solves found a solution\n";
+        return false;
+    }
+    const auto variant = make_variant(best, inst.deliveries.size(), base_seed);
+    std::cout << "Portfolio: " << finished << " of " << solves << " solves done, best makespan "
+              << makespan(move_strings) << " from solve " << best << " ("
+              << (variant.delivery_order.empty() ? "file order" : "shuffled order") << ", "
+              << tie_break_name(variant.tie_break) << ", seed " << variant.seed << ")\n";
+    return true;
+}
@@ -0,0 +1,22 @@
+#ifndef MAPF_PORTFOLIO_H
+#define MAPF_PORTFOLIO_H
+
+#include "input_parsing.h"
+#include "options.h"
+#include "solver.h"
+
+class DistanceTable;
+
+/*
+ * Runs options.portfolio_size independent prioritized solves (one per thread if 0) on options.threads threads, each
+ * with its own reservations and its own delivery order, robot tie break and seed. The first solve is the plain one,
+ * the next ones keep the file order with the other tie breaks, all further ones shuffle the delivery order.
+ *
+ * Keeps the solution with the smallest makespan. Once options.time_limit is over, the best solution found so far is
+ * taken and the remaining solves are stopped, if there is none yet the first one to complete is.
+ * @return false if no solve found a solution, otherwise routes holds the routes of the kept one
+ */
+bool solve_portfolio(const Instance &inst, const DistanceTable &distances, const Options &options,
+                     MoveStrings &move_strings, Routes &routes);
+
+#endif //MAPF_PORTFOLIO_H
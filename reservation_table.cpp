@@ -0,0 +1,212 @@
+#include "reservation_table.h"
+
+#include <algorithm>
+#include <utility>
+
+ReservationTable::ReservationTable(std::shared_ptr<const Grid> grid)
+        : m_grid(std::move(grid)), m_width{m_grid->width()}, m_height{m_grid->height()},
+          m_words_per_layer{(m_grid->cells() + 63u) / 64u},
+          m_first_layer{0}, m_layers{0}, m_dropped_before{0}, m_count{0}, m_obstacles(m_words_per_layer, 0),
+          m_parked_from(m_grid->cells(), never_blocked) {
+    for (int32_t y{0}; y < m_height; ++y) {
+        for (int32_t x{0}; x < m_width; ++x) {
+            if (m_grid->is_wall(x, y)) {
+                add_obstacle(x, y);
+            }
+        }
+    }
+}
+
+ReservationTable::ReservationTable(int32_t width, int32_t height)
+        : ReservationTable(std::make_shared<const Grid>(width, height)) {}
+
+void ReservationTable::reserve(int32_t x, int32_t y, int32_t t) {
+    if (t < m_dropped_before || !in_bounds(x, y)) {
+        return;
+    }
+    ensure_layer(t + 1);
+
+    if (!test(m_occupied, x, y, t)) {
+        ++m_count;
+    }
+    set(m_occupied, x, y, t);
+    if (t > m_first_layer) {
+        set(m_blocked, x, y, t - 1);
+    }
+    set(m_blocked, x, y, t);
+    set(m_blocked, x, y, t + 1);
+}
+
+void ReservationTable::reserve(SpaceTimePoint p) {
+    reserve(p.x, p.y, p.t);
+}
+
+void ReservationTable::release(int32_t x, int32_t y, int32_t t) {
+    if (!test(m_occupied, x, y, t)) {
+        return;
+    }
+    --m_count;
+    clear(m_occupied, x, y, t);
+    // the blocked bit of a layer is the or of the occupied bits of its own and both neighbouring layers
+    for (auto u = std::max(t - 1, m_first_layer); u <= t + 1 && u < m_layers; ++u) {
+        if (!test(m_occupied, x, y, u - 1) && !test(m_occupied, x, y, u) && !test(m_occupied, x, y, u + 1)) {
+            clear(m_blocked, x, y, u);
+        }
+    }
+}
+
+void ReservationTable::release(SpaceTimePoint p) {
+    release(p.x, p.y, p.t);
+}
+
+void ReservationTable::add_obstacle(int32_t x, int32_t y) {
+    if (in_bounds(x, y)) {
+        set(m_obstacles, x, y, 0);
+    }
+}
+
+bool ReservationTable::is_obstacle(int32_t x, int32_t y) const {
+    return in_bounds(x, y) && ((m_obstacles[cell_word(x, y)] >> cell_bit(x, y)) & 1u);
+}
+
+void ReservationTable::park(int32_t x, int32_t y, int32_t t) {
+    if (in_bounds(x, y)) {
+        m_parked_from[static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x)] = t;
+    }
+}
+
+void ReservationTable::unpark(int32_t x, int32_t y) {
+    park(x, y, never_blocked);
+}
+
+void ReservationTable::drop_before(int32_t t) {
+    if (t <= m_dropped_before) {
+        return;
+    }
+    m_dropped_before = t;
+
+    // compact once at least half of the stored layers are dead, so every layer is moved O(1) times on average
+    const auto dead = std::min(t, m_layers) - m_first_layer;
+    if (dead < 64 || dead < (m_layers - m_first_layer) / 2) {
+        return;
+    }
+    const auto words = static_cast<size_t>(dead) * m_words_per_layer;
+    for (size_t k{0}; k < words; ++k) {
+        m_count -= static_cast<size_t>(__builtin_popcountll(m_occupied[k]));
+    }
+    m_occupied.erase(m_occupied.begin(), m_occupied.begin() + static_cast<std::ptrdiff_t>(words));
+    m_blocked.erase(m_blocked.begin(), m_blocked.begin() + static_cast<std::ptrdiff_t>(words));
+    m_first_layer += dead;
+}
+
+bool ReservationTable::is_free(int32_t x, int32_t y, int32_t t) const {
+    return !is_obstacle(x, y) && !test(m_occupied, x, y, t) && t < parked_from(x, y);
+}
+
+bool ReservationTable::is_free_around(int32_t x, int32_t y, int32_t t) const {
+    return !is_obstacle(x, y) && !test(m_blocked, x, y, t) && int64_t{t} + 1 < parked_from(x, y);
+}
+
+bool ReservationTable::is_free_around(SpaceTimePoint p) const {
+    return is_free_around(p.x, p.y, p.t);
+}
+
+int32_t ReservationTable::next_blocked(int32_t x, int32_t y, int32_t t) const {
+    if (is_obstacle(x, y)) {
+        return t;
+    }
+    // a parked robot blocks the field from one step before it arrives
+    const auto parked = parked_from(x, y);
+    const auto parked_blocked = parked == never_blocked ? never_blocked : std::max(t, parked - 1);
+    for (t = std::max(t, m_dropped_before); t < m_layers && t < parked_blocked; ++t) {
+        if (test(m_blocked, x, y, t)) {
+            return t;
+        }
+    }
+    return parked_blocked;
+}
+
+int32_t ReservationTable::next_free(int32_t x, int32_t y, int32_t t) const {
+    if (is_obstacle(x, y) || !in_bounds(x, y)) {
+        return never_free;
+    }
+    for (t = std::max(t, 0); t < m_layers; ++t) {
+        if (!test(m_blocked, x, y, t)) {
+            break;
+        }
+    }
+    return int64_t{t} + 1 < parked_from(x, y) ? t : never_free;
+}
+
+bool ReservationTable::empty() const noexcept {
+    return m_count == 0;
+}
+
+int32_t ReservationTable::width() const noexcept {
+    return m_width;
+}
+
+int32_t ReservationTable::height() const noexcept {
+    return m_height;
+}
+
+const Grid &ReservationTable::grid() const noexcept {
+    return *m_grid;
+}
+
+int32_t ReservationTable::horizon() const noexcept {
+    return m_layers;
+}
+
+int32_t ReservationTable::first_layer() const noexcept {
+    return m_first_layer;
+}
+
+bool ReservationTable::in_bounds(int32_t x, int32_t y) const noexcept {
+    return x >= 0 && y >= 0 && x < m_width && y < m_height;
+}
+
+int32_t ReservationTable::parked_from(int32_t x, int32_t y) const noexcept {
+    if (!in_bounds(x, y)) {
+        return never_blocked;
+    }
+    return m_parked_from[static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x)];
+}
+
+void ReservationTable::ensure_layer(int32_t t) {
+    if (t < m_layers) {
+        return;
+    }
+    // grow geometrically, so a path reserved step by step doesn't reallocate for every single layer
+    const auto layers = std::max(t + 1, m_layers + (m_layers - m_first_layer) / 2);
+    const auto stored = static_cast<size_t>(layers - m_first_layer);
+    m_occupied.resize(stored * m_words_per_layer, 0);
+    m_blocked.resize(stored * m_words_per_layer, 0);
+    m_layers = layers;
+}
+
+size_t ReservationTable::cell_word(int32_t x, int32_t y) const noexcept {
+    return (static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x)) / 64u;
+}
+
+uint32_t ReservationTable::cell_bit(int32_t x, int32_t y) const noexcept {
+    return (static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x)) % 64u;
+}
+
+bool ReservationTable::test(const std::vector<uint64_t> &bits, int32_t x, int32_t y, int32_t t) const noexcept {
+    if (t < m_dropped_before || t >= m_layers || !in_bounds(x, y)) {
+        return false;
+    }
+    const auto word = static_cast<size_t>(t - m_first_layer) * m_words_per_layer + cell_word(x, y);
+    return (bits[word] >> cell_bit(x, y)) & 1u;
+}
+
+void ReservationTable::set(std::vector<uint64_t> &bits, int32_t x, int32_t y, int32_t t) noexcept {
+    const auto word = static_cast<size_t>(t - m_first_layer) * m_words_per_layer + cell_word(x, y);
+    bits[word] |= uint64_t{1} << cell_bit(x, y);
+}
+
+void ReservationTable::clear(std::vector<uint64_t> &bits, int32_t x, int32_t y, int32_t t) noexcept {
+    const auto word = static_cast<size_t>(t - m_first_layer) * m_words_per_layer + cell_word(x, y);
+    bits[word] &= ~(uint64_t{1} << cell_bit(x, y));
+}
@@ -0,0 +1,142 @@
+#ifndef MAPF_RESERVATION_TABLE_H
+#define MAPF_RESERVATION_TABLE_H
+
+#include <cstdint>
+#include <climits>
+#include <memory>
+#include <vector>
+
+#include "grid.h"
+#include "pathfinding.h"
+
+/* Dense space-time occupancy table. Every time step owns one layer of width * height bits, layers are appended
+ * on demand when a reservation further in the future is made.
+ *
+ * Next to the exact occupancy a second "blocked" bitmap is kept, in which a reservation at (x, y, t) also marks
+ * (x, y, t - 1) and (x, y, t + 1). A field is only usable for a robot if nobody is there one step before (we would
+ * train them), at the same time, or one step after (they would train us), which makes that check a single bit test.
+ *
+ * Walls come from the static grid the table is built on and are never free at any time, the grid is shared between
+ * all tables of an instance. A parked robot reserves its field from some time
+ * on for good, until it is unparked again.
+ *
+ * Time stays absolute, but layers before a point in time can be dropped once nobody will ask about them anymore, so a
+ * long running simulation only keeps the layers from the current time on.
+ */
+class ReservationTable {
+public:
+    static constexpr int32_t never_blocked = INT32_MAX;
+    static constexpr int32_t never_free = INT32_MAX;
+
+    explicit ReservationTable(std::shared_ptr<const Grid> grid);
+
+    /*
+     * A table over an empty grid without walls
+     */
+    ReservationTable(int32_t width, int32_t height);
+
+    void reserve(int32_t x, int32_t y, int32_t t);
+
+    void reserve(SpaceTimePoint p);
+
+    /*
+     * Takes back the reservation of (x, y, t). The fields around it in time stay blocked as far as their own
+     * reservations or those of their other neighbours ask for it. Every point is taken to be reserved by at most one
+     * robot, which planning around the table ensures, so this removes exactly that robot from (x, y, t).
+     */
+    void release(int32_t x, int32_t y, int32_t t);
+
+    void release(SpaceTimePoint p);
+
+    /*
+     * Blocks (x, y) for all time steps, on top of the walls of the grid
+     */
+    void add_obstacle(int32_t x, int32_t y);
+
+    bool is_obstacle(int32_t x, int32_t y) const;
+
+    /*
+     * Reserves (x, y) for all time steps from t on, until unpark(x, y) is called
+     */
+    void park(int32_t x, int32_t y, int32_t t);
+
+    void unpark(int32_t x, int32_t y);
+
+    /*
+     * Forgets all reservations before t, queries before t then see a free table. Memory is only given back once enough
+     * layers have been dropped.
+     */
+    void drop_before(int32_t t);
+
+    /*
+     * @return true iff exactly (x, y, t) is not reserved
+     */
+    bool is_free(int32_t x, int32_t y, int32_t t) const;
+
+    /*
+     * @return true iff (x, y) is not reserved at any of t - 1, t and t + 1
+     */
+    bool is_free_around(int32_t x, int32_t y, int32_t t) const;
+
+    bool is_free_around(SpaceTimePoint p) const;
+
+    /*
+     * @return the first t' >= t at which (x, y) is not free around, never_blocked if there is none
+     */
+    int32_t next_blocked(int32_t x, int32_t y, int32_t t) const;
+
+    /*
+     * @return the first t' >= t at which (x, y) is free around, never_free if there is none (walls)
+     */
+    int32_t next_free(int32_t x, int32_t y, int32_t t) const;
+
+    bool empty() const noexcept;
+
+    int32_t width() const noexcept;
+
+    int32_t height() const noexcept;
+
+    const Grid &grid() const noexcept;
+
+    /*
+     * @return end of the allocated time layers, every reservation has t < horizon()
+     */
+    int32_t horizon() const noexcept;
+
+    /*
+     * @return first time step still stored, everything before has been dropped
+     */
+    int32_t first_layer() const noexcept;
+
+private:
+    bool in_bounds(int32_t x, int32_t y) const noexcept;
+
+    int32_t parked_from(int32_t x, int32_t y) const noexcept;
+
+    void ensure_layer(int32_t t);
+
+    size_t cell_word(int32_t x, int32_t y) const noexcept;
+
+    uint32_t cell_bit(int32_t x, int32_t y) const noexcept;
+
+    bool test(const std::vector<uint64_t> &bits, int32_t x, int32_t y, int32_t t) const noexcept;
+
+    void set(std::vector<uint64_t> &bits, int32_t x, int32_t y, int32_t t) noexcept;
+
+    void clear(std::vector<uint64_t> &bits, int32_t x, int32_t y, int32_t t) noexcept;
+
+    std::shared_ptr<const Grid> m_grid;
+    int32_t m_width;
+    int32_t m_height;
+    size_t m_words_per_layer;
+    int32_t m_first_layer; // absolute time of the first stored layer
+    int32_t m_layers; // absolute time one after the last stored layer
+    int32_t m_dropped_before;
+    size_t m_count;
+    std::vector<uint64_t> m_occupied;
+    std::vector<uint64_t> m_blocked;
+    std::vector<uint64_t> m_obstacles;
+    std::vector<int32_t> m_parked_from; // per cell, never_blocked if nobody is parked there
+};
+
+#endif //MAPF_RESERVATION_TABLE_H
@@ -0,0 +1,144 @@
+#include "search_context.h"
+
+#include <algorithm>
+
+namespace {
+    const size_t initial_table_size{1u << 12u};
+}
+
+SearchContext::SearchContext()
+        : m_table(initial_table_size, -1), m_base{0}, m_cursor{0}, m_sorted{true}, m_open_size{0} {}
+
+void SearchContext::reset() {
+    for (const auto slot : m_touched) {
+        m_table[slot] = -1;
+    }
+    m_touched.clear();
+    m_nodes.clear();
+    for (const auto k : m_touched_buckets) {
+        m_buckets[k].clear();
+    }
+    m_touched_buckets.clear();
+    m_cursor = 0;
+    m_sorted = true;
+    m_open_size = 0;
+}
+
+size_t SearchContext::slot_of(SpaceTimePoint p) const noexcept {
+    uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(p.x)) << 42u)
+                   ^ (static_cast<uint64_t>(static_cast<uint32_t>(p.y)) << 21u)
+                   ^ static_cast<uint64_t>(static_cast<uint32_t>(p.t));
+    // splitmix64 finalizer, the table size is a power of two so the low bits have to be well mixed
+    key ^= key >> 30u;
+    key *= 0xbf58476d1ce4e5b9u;
+    key ^= key >> 27u;
+    key *= 0x94d049bb133111ebu;
+    key ^= key >> 31u;
+    return static_cast<size_t>(key) & (m_table.size() - 1);
+}
+
+int32_t SearchContext::find(SpaceTimePoint p) const {
+    for (size_t slot = slot_of(p);; slot = (slot + 1) & (m_table.size() - 1)) {
+        const auto id = m_table[slot];
+        if (id < 0) {
+            return -1;
+        }
+        if (m_nodes[id].p == p) {
+            return id;
+        }
+    }
+}
+
+int32_t SearchContext::add(SpaceTimePoint p, int32_t parent, int32_t charge) {
+    if (2 * (m_nodes.size() + 1) > m_table.size()) {
+        grow_table();
+    }
+    const auto id = static_cast<int32_t>(m_nodes.size());
+    m_nodes.push_back({p, parent, charge});
+
+    auto slot = slot_of(p);
+    while (m_table[slot] >= 0) {
+        slot = (slot + 1) & (m_table.size() - 1);
+    }
+    m_table[slot] = id;
+    m_touched.push_back(slot);
+    return id;
+}
+
+void SearchContext::grow_table() {
+    m_table.assign(m_table.size() * 2, -1);
+    m_touched.clear();
+    for (size_t id{0}; id < m_nodes.size(); ++id) {
+        auto slot = slot_of(m_nodes[id].p);
+        while (m_table[slot] >= 0) {
+            slot = (slot + 1) & (m_table.size() - 1);
+        }
+        m_table[slot] = static_cast<int32_t>(id);
+        m_touched.push_back(slot);
+    }
+}
+
+void SearchContext::update(int32_t id, int32_t parent, int32_t charge) {
+    m_nodes[id].parent = parent;
+    m_nodes[id].charge = charge;
+}
+
+const SearchContext::Node &SearchContext::node(int32_t id) const {
+    return m_nodes[id];
+}
+
+size_t SearchContext::size() const noexcept {
+    return m_nodes.size();
+}
+
+void SearchContext::push_open(int32_t id, uint32_t f, uint32_t h) {
+    // The start is pushed first and the heuristics of all planners are consistent, so no f is below that of the
+    // start and the buckets never have to be shifted. Should an inconsistent one get below, it goes to the lowest.
+    if (m_touched_buckets.empty()) {
+        m_base = f;
+    }
+    const size_t k = f < m_base ? 0 : f - m_base;
+    if (k >= m_buckets.size()) {
+        m_buckets.resize(k + 1);
+    }
+
+    auto &bucket = m_buckets[k];
+    if (bucket.empty()) {
+        m_touched_buckets.push_back(k);
+    }
+    if (k < m_cursor) {
+        m_cursor = k;
+        m_sorted = true;
+    } else if (k == m_cursor && !bucket.empty() && h > bucket.back().h) {
+        m_sorted = false;
+    }
+    bucket.push_back({h, id});
+    ++m_open_size;
+}
+
+int32_t SearchContext::pop_open() {
+    while (m_buckets[m_cursor].empty()) {
+        ++m_cursor;
+        m_sorted = false;
+    }
+    auto &bucket = m_buckets[m_cursor];
+    if (!m_sorted) {
+        std::sort(bucket.begin(), bucket.end(), [](const OpenEntry &e1, const OpenEntry &e2) {
+            return e1.h > e2.h;
+        });
+        m_sorted = true;
+    }
+    const auto id = bucket.back().id;
+    bucket.pop_back();
+    --m_open_size;
+    return id;
+}
+
+bool SearchContext::open_empty() const noexcept {
+    return m_open_size == 0;
+}
+
+SearchContext &default_search_context() {
+    thread_local SearchContext context;
+    return context;
+}
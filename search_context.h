@@ -0,0 +1,90 @@
+#ifndef MAPF_SEARCH_CONTEXT_H
+#define MAPF_SEARCH_CONTEXT_H
+
+#include <cstdint>
+#include <vector>
+
+#include "pathfinding.h"
+
+/* Reusable buffers for a single space time search. Nodes live in a flat pool and are referred to by their index,
+ * parents are indices as well. The closed set is an open addressing table over node ids that is cleared by only
+ * visiting the slots that were touched, so resetting costs O(nodes of the last search), not O(capacity).
+ *
+ * The open list is a bucket queue over f, which is a small integer in all planners: one stack per f from the f of the
+ * first push (the start) up, popped from the lowest f up. Within a bucket the entry with the smallest h, so the
+ * largest g, comes first, which takes the search straight down a path instead of widening the front. A bucket is
+ * sorted by h once when it becomes the lowest one, afterwards pushes of the same f are always the closest ones yet as
+ * long as h is consistent. So a push is O(1) amortized and a pop O(log b) amortized, with b the size of its bucket,
+ * plus skipping the empty buckets below it.
+ *
+ * After a few searches all buffers have reached their working size and a search does no more heap allocations.
+ * A context must not be shared between threads.
+ */
+class SearchContext {
+public:
+    struct Node {
+        SpaceTimePoint p;
+        int32_t parent;
+        int32_t charge;
+    };
+
+    SearchContext();
+
+    void reset();
+
+    /*
+     * @return the id of the node at p or -1 if p hasn't been seen during this search
+     */
+    int32_t find(SpaceTimePoint p) const;
+
+    /*
+     * Adds a node that must not have been seen during this search.
+     * @return id of the new node
+     */
+    int32_t add(SpaceTimePoint p, int32_t parent, int32_t charge);
+
+    /*
+     * Replaces the parent and charge of a node, e.g. when a cheaper way to it was found.
+     */
+    void update(int32_t id, int32_t parent, int32_t charge);
+
+    const Node &node(int32_t id) const;
+
+    size_t size() const noexcept;
+
+    /*
+     * @param f g + h of the node, with g its time in all planners
+     */
+    void push_open(int32_t id, uint32_t f, uint32_t h);
+
+    int32_t pop_open();
+
+    bool open_empty() const noexcept;
+
+private:
+    struct OpenEntry {
+        uint32_t h; // the f of an entry is its bucket
+        int32_t id;
+    };
+
+    size_t slot_of(SpaceTimePoint p) const noexcept;
+
+    void grow_table();
+
+    std::vector<Node> m_nodes;
+    std::vector<int32_t> m_table;
+    std::vector<size_t> m_touched;
+    std::vector<std::vector<OpenEntry>> m_buckets; // m_buckets[k] holds the entries with f = m_base + k
+    std::vector<size_t> m_touched_buckets;
+    uint32_t m_base; // the f of the start of the search
+    size_t m_cursor;  // no bucket below holds an entry
+    bool m_sorted;    // the cursor bucket has its smallest h at the back
+    size_t m_open_size;
+};
+
+/*
+ * @return the context used by the a_star overload without an explicit context, one per thread
+ */
+SearchContext &default_search_context();
+
+#endif //MAPF_SEARCH_CONTEXT_H
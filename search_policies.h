@@ -0,0 +1,158 @@
+#ifndef MAPF_SEARCH_POLICIES_H
+#define MAPF_SEARCH_POLICIES_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "distance_table.h"
+#include "grid.h"
+#include "pathfinding.h"
+
+/* The parts the planners are put together from. Every policy is a small value type with inline members, a planner
+ * kernel templated over them gets its own copy of the search loop per combination with all calls inlined, so a new
+ * combination costs nothing per expanded node.
+ *
+ * Heuristic:     uint32_t operator()(SpaceTimePoint p), the steps still needed from p
+ * Neighbourhood: Neighbours operator()(SpaceTimePoint p), the points a robot at p may be on one step later
+ * Energy:        int32_t after(int32_t charge, bool moved), the charge left after a step
+ *                bool allows(SpaceTimePoint p, int32_t charge), whether a robot may be on p with charge left
+ *
+ * The kernels and GridNeighbourhood take the reservations as a template parameter too, anything with the grid(),
+ * is_free_around(SpaceTimePoint) and next_blocked(x, y, t) of ReservationTable will do.
+ */
+
+struct ManhattanHeuristic {
+    uint32_t operator()(SpaceTimePoint p) const noexcept {
+        return manhatten_distance(p, goal);
+    }
+
+    SpacePoint goal;
+};
+
+/* The exact distance from a field of a DistanceTable, DistanceTable::unreachable where there is no way.
+ */
+struct FieldHeuristic {
+    uint32_t operator()(SpaceTimePoint p) const noexcept {
+        return field[static_cast<size_t>(p.y) * width + static_cast<size_t>(p.x)];
+    }
+
+    const uint16_t *field;
+    size_t width;
+};
+
+/* The field of a DistanceTable towards target if it has one, the manhattan distance to target otherwise.
+ */
+struct TargetHeuristic {
+    uint32_t operator()(SpaceTimePoint p) const noexcept {
+        return field ? field[static_cast<size_t>(p.y) * width + static_cast<size_t>(p.x)]
+                     : manhatten_distance(p, target);
+    }
+
+    const uint16_t *field;
+    size_t width;
+    SpacePoint target;
+};
+
+/* Four connected moves on the grid of the reservations, or staying, onto fields that are free around the next time
+ * step, see ReservationTable::is_free_around.
+ */
+template<typename Reservations>
+class GridNeighbourhood {
+public:
+    explicit GridNeighbourhood(const Reservations &reservations) : m_reservations(reservations) {}
+
+    /*
+     * The fields next to (x, y) the grid allows moving to, in the order left, right, up, down, whoever is there.
+     * @return the number of fields written to moves
+     */
+    size_t moves(int32_t x, int32_t y, std::array<SpacePoint, 4> &moves) const noexcept {
+        const auto mask = m_reservations.grid().neighbours(x, y);
+        size_t count{0};
+        if (mask & Grid::left) {
+            moves[count++] = SpacePoint(x - 1, y);
+        }
+        if (mask & Grid::right) {
+            moves[count++] = SpacePoint(x + 1, y);
+        }
+        if (mask & Grid::up) {
+            moves[count++] = SpacePoint(x, y - 1);
+        }
+        if (mask & Grid::down) {
+            moves[count++] = SpacePoint(x, y + 1);
+        }
+        return count;
+    }
+
+    /*
+     * @return the free points one step after p, staying first, then the moves
+     */
+    Neighbours operator()(SpaceTimePoint p) const {
+        Neighbours valid_neighbours;
+        const auto add_if_free = [&](SpaceTimePoint n) {
+            ++valid_neighbours.checked;
+            // we must neither train someone else (t - 1) nor force someone else into training us (t + 1)
+            if (m_reservations.is_free_around(n)) {
+                valid_neighbours.points[valid_neighbours.count++] = n;
+            }
+        };
+
+        add_if_free(SpaceTimePoint(p.x, p.y, p.t + 1));
+        std::array<SpacePoint, 4> next{{{0, 0}, {0, 0}, {0, 0}, {0, 0}}};
+        const auto count = moves(p.x, p.y, next);
+        for (size_t k{0}; k < count; ++k) {
+            add_if_free(SpaceTimePoint(next[k], p.t + 1));
+        }
+        return valid_neighbours;
+    }
+
+private:
+    const Reservations &m_reservations;
+};
+
+/* For searches where the charge can't run out, e.g. because they give up earlier.
+ */
+struct UnlimitedEnergy {
+    int32_t after(int32_t charge, bool /*moved*/) const noexcept {
+        return charge;
+    }
+
+    bool allows(SpaceTimePoint /*p*/, int32_t /*charge*/) const noexcept {
+        return true;
+    }
+};
+
+/* Every move takes one unit of charge, staying takes none.
+ */
+struct BatteryEnergy {
+    int32_t after(int32_t charge, bool moved) const noexcept {
+        return moved ? charge - 1 : charge;
+    }
+
+    bool allows(SpaceTimePoint /*p*/, int32_t charge) const noexcept {
+        return charge >= 0;
+    }
+};
+
+/* Like BatteryEnergy, but the robot always keeps enough charge to get to a charger from wherever it is.
+ */
+struct ChargerReserveEnergy {
+    int32_t after(int32_t charge, bool moved) const noexcept {
+        return moved ? charge - 1 : charge;
+    }
+
+    bool allows(SpaceTimePoint p, int32_t charge) const noexcept {
+        if (charge < 0) {
+            return false;
+        }
+        if (!charger_distance.field) {
+            return true;
+        }
+        const auto needed = charger_distance(p);
+        return needed == DistanceTable::unreachable || static_cast<uint32_t>(charge) >= needed;
+    }
+
+    FieldHeuristic charger_distance; // field may be null if there are no chargers
+};
+
+#endif //MAPF_SEARCH_POLICIES_H
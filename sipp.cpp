@@ -0,0 +1,142 @@
+#include "sipp.h"
+
+#include "distance_table.h"
+#include "reservation_table.h"
+#include "search_context.h"
+#include "stats.h"
+
+namespace {
+    /* Per state data that doesn't fit into SearchContext::Node. Node::p is (x, y, end of the safe interval), which
+     * identifies the state, the time we arrive there lives here. Indexed by node id.
+     */
+    struct SippBuffers {
+        std::vector<int32_t> arrival;
+        std::vector<bool> closed;
+    };
+
+    SippBuffers &sipp_buffers() {
+        thread_local SippBuffers buffers;
+        return buffers;
+    }
+
+    CompactPath
+    reconstruct_sipp_path(const SearchContext &context, const std::vector<int32_t> &arrival, int32_t goal_id) {
+        std::vector<int32_t> states;
+        for (auto id = goal_id; id >= 0; id = context.node(id).parent) {
+            states.push_back(id);
+        }
+
+        CompactPath path;
+        for (auto it = states.rbegin(); it != states.rend(); ++it) {
+            const auto p = context.node(*it).p;
+            if (!path.empty()) {
+                // wait on the previous field until we have to leave
+                while (path.back().t + 1 < arrival[*it]) {
+                    path.push_back(Move::Rest);
+                }
+            }
+            path.push_back(SpaceTimePoint(p.x, p.y, arrival[*it]));
+        }
+        return path;
+    }
+}
+
+CompactPath
+sipp(const SpaceTimePoint start, const SpacePoint goal, uint32_t rest_after, int32_t charge, uint32_t width,
+     uint32_t height, const ReservationTable &reservations, const DistanceTable *distances, SearchContext &context) {
+    if (charge < 0) {
+        return CompactPath{};
+    }
+
+    const uint16_t *goal_field = distances ? distances->field(goal) : nullptr;
+    const auto h = [goal, goal_field, width](int32_t x, int32_t y) -> uint32_t {
+        if (goal_field) {
+            return goal_field[static_cast<size_t>(y) * width + static_cast<size_t>(x)];
+        }
+        return manhatten_distance(SpacePoint(x, y), goal);
+    };
+    if (h(start.x, start.y) == DistanceTable::unreachable) {
+        return CompactPath{};
+    }
+
+    auto &buffers = sipp_buffers();
+    buffers.arrival.clear();
+    buffers.closed.clear();
+    context.reset();
+    SearchRecorder recorder(context);
+
+    // last time step of the safe interval containing t
+    const auto interval_end = [&reservations, &recorder](int32_t x, int32_t y, int32_t t) {
+        ++recorder.lookups;
+        const auto blocked = reservations.next_blocked(x, y, t);
+        return blocked == ReservationTable::never_blocked ? blocked : blocked - 1;
+    };
+    const auto next_free = [&reservations, &recorder](int32_t x, int32_t y, int32_t t) {
+        ++recorder.lookups;
+        return reservations.next_free(x, y, t);
+    };
+
+    const auto add_state = [&](SpaceTimePoint state, int32_t parent, int32_t state_charge, int32_t t) {
+        const auto id = context.add(state, parent, state_charge);
+        buffers.arrival.push_back(t);
+        buffers.closed.push_back(false);
+        context.push_open(id, h(state.x, state.y) + t, h(state.x, state.y));
+    };
+
+    // we are already standing on start, and may stay there until someone else needs the field
+    add_state(SpaceTimePoint(start.x, start.y, interval_end(start.x, start.y, start.t + 1)), -1, charge, start.t);
+
+    while (!context.open_empty()) {
+        const auto curr_id = context.pop_open();
+        if (buffers.closed[curr_id]) { // outdated open list entry, a cheaper one has been expanded already
+            continue;
+        }
+        buffers.closed[curr_id] = true;
+
+        const auto curr = context.node(curr_id);
+        const auto t = buffers.arrival[curr_id];
+        const auto end = curr.p.t;
+
+        if (SpacePoint(curr.p) == goal
+            && (end == ReservationTable::never_blocked || static_cast<int64_t>(end) - t >= rest_after)) {
+            recorder.found = true;
+            return reconstruct_sipp_path(context, buffers.arrival, curr_id);
+        }
+        if (curr.charge == 0) { // waiting is free, but it doesn't get us anywhere
+            continue;
+        }
+        ++recorder.expanded;
+
+        // we may leave at any time in [t, end] and arrive one step later
+        const int64_t latest_arrival = end == ReservationTable::never_blocked ? INT64_MAX : int64_t{end} + 1;
+        const SpacePoint moves[] = {{curr.p.x - 1, curr.p.y}, {curr.p.x + 1, curr.p.y},
+                                    {curr.p.x, curr.p.y - 1}, {curr.p.x, curr.p.y + 1}};
+        for (const auto n : moves) {
+            if (n.x < 0 || n.y < 0 || n.x >= static_cast<int32_t>(width) || n.y >= static_cast<int32_t>(height)) {
+                continue;
+            }
+
+            for (auto arrive = next_free(n.x, n.y, t + 1);
+                 arrive != ReservationTable::never_free && arrive <= latest_arrival;) {
+                const auto n_end = interval_end(n.x, n.y, arrive);
+                const SpaceTimePoint state(n.x, n.y, n_end);
+
+                const auto id = context.find(state);
+                if (id < 0) {
+                    add_state(state, curr_id, curr.charge - 1, arrive);
+                } else if (!buffers.closed[id] && arrive < buffers.arrival[id]) {
+                    context.update(id, curr_id, curr.charge - 1);
+                    buffers.arrival[id] = arrive;
+                    context.push_open(id, h(n.x, n.y) + arrive, h(n.x, n.y));
+                }
+
+                if (n_end == ReservationTable::never_blocked) {
+                    break;
+                }
+                arrive = next_free(n.x, n.y, n_end + 1);
+            }
+        }
+    }
+
+    return CompactPath{};
+}
@@ -0,0 +1,21 @@
+#ifndef MAPF_SIPP_H
+#define MAPF_SIPP_H
+
+#include "compact_path.h"
+#include "pathfinding.h"
+
+/**
+ * Safe Interval Path Planning, drop-in replacement for a_star.
+ *
+ * Instead of one state per (x, y, t), a state is a field together with a safe interval, i.e. a maximal range of time
+ * in which the field is free around (see ReservationTable::is_free_around). Waiting happens implicitly inside an
+ * interval, so a long wait costs a single expansion and no cutoff is needed, the number of states is finite.
+ *
+ * The goal is only accepted if it stays free for rest_after time units after arrival. Parameters are the same as
+ * for a_star, context is used for the node pool and the open list.
+ */
+CompactPath
+sipp(SpaceTimePoint start, SpacePoint goal, uint32_t rest_after, int32_t charge, uint32_t width, uint32_t height,
+     const ReservationTable &reservations, const DistanceTable *distances, SearchContext &context);
+
+#endif //MAPF_SIPP_H
@@ -0,0 +1,145 @@
+#include "solution_writer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    uint8_t action_code(char action) {
+        switch (action) {
+            case 'S':
+                return 0;
+            case 'U':
+                return 1;
+            case 'D':
+                return 2;
+            case 'L':
+                return 3;
+            case 'R':
+                return 4;
+            default:
+                return 5; // the package id, loading or unloading, parsing rules out ids that are moves
+        }
+    }
+
+    void append_le(std::vector<char> &bytes, uint32_t value) {
+        for (uint32_t k{0}; k < 4; ++k) {
+            bytes.push_back(static_cast<char>((value >> (8u * k)) & 0xFFu));
+        }
+    }
+}
+
+SolutionWriter::SolutionWriter(const std::string &filename, std::vector<int32_t> robot_ids, OutputFormat format,
+                               size_t buffer_size)
+        : m_file(filename, std::ios::binary), m_robot_ids(std::move(robot_ids)), m_format{format},
+          m_buffer(std::max(buffer_size, m_robot_ids.size() + 1)), m_used{0}, m_rows{0},
+          m_packed((3 * m_robot_ids.size() + 7) / 8) {
+    if (m_format == OutputFormat::Binary && m_file) {
+        std::vector<char> header{'M', 'A', 'P', 'F', 2, 3, 0, 0};
+        append_le(header, static_cast<uint32_t>(m_robot_ids.size()));
+        for (const auto id : m_robot_ids) {
+            append_le(header, static_cast<uint32_t>(id));
+        }
+        append(header.data(), header.size());
+    }
+}
+
+SolutionWriter::~SolutionWriter() {
+    flush();
+}
+
+bool SolutionWriter::is_open() const {
+    return static_cast<bool>(m_file);
+}
+
+void SolutionWriter::write_row(const char *actions) {
+    const auto robots = m_robot_ids.size();
+    if (m_format == OutputFormat::Text) {
+        if (m_buffer.size() - m_used < robots + 1) {
+            flush();
+        }
+        std::memcpy(m_buffer.data() + m_used, actions, robots);
+        m_buffer[m_used + robots] = '\n';
+        m_used += robots + 1;
+    } else {
+        const auto row_bytes = (3 * robots + 7) / 8;
+        m_packed.assign(row_bytes, 0);
+        for (size_t k{0}; k < robots; ++k) {
+            // an action may straddle two bytes
+            const auto bit = 3 * k;
+            const auto action = action_code(actions[k]);
+            const uint32_t code = action << (bit % 8);
+            m_packed[bit / 8] |= static_cast<uint8_t>(code & 0xFFu);
+            if (code > 0xFFu) {
+                m_packed[bit / 8 + 1] |= static_cast<uint8_t>(code >> 8u);
+            }
+            if (action == 5) {
+                m_packed.push_back(static_cast<uint8_t>(actions[k]));
+            }
+        }
+        append(reinterpret_cast<const char *>(m_packed.data()), m_packed.size());
+    }
+    ++m_rows;
+}
+
+void SolutionWriter::flush() {
+    if (m_used > 0) {
+        m_file.write(m_buffer.data(), static_cast<std::streamsize>(m_used));
+        m_used = 0;
+    }
+    m_file.flush();
+}
+
+bool SolutionWriter::good() const {
+    return m_file.good();
+}
+
+size_t SolutionWriter::rows() const noexcept {
+    return m_rows;
+}
+
+void SolutionWriter::append(const char *data, size_t size) {
+    while (size > 0) {
+        if (m_used == m_buffer.size()) {
+            flush();
+        }
+        const auto n = std::min(size, m_buffer.size() - m_used);
+        std::memcpy(m_buffer.data() + m_used, data, n);
+        m_used += n;
+        data += n;
+        size -= n;
+    }
+}
+
+bool write_solution(const std::vector<std::pair<int32_t, std::string>> &move_strings, const std::string &filename,
+                    OutputFormat format) {
+    // order by robot id without moving the strings around
+    std::vector<size_t> order(move_strings.size());
+    for (size_t k{0}; k < order.size(); ++k) {
+        order[k] = k;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t k1, size_t k2) {
+        return move_strings[k1].first < move_strings[k2].first;
+    });
+
+    std::vector<int32_t> robot_ids;
+    size_t makespan{0};
+    for (const auto k : order) {
+        robot_ids.push_back(move_strings[k].first);
+        makespan = std::max(makespan, move_strings[k].second.size());
+    }
+
+    SolutionWriter writer(filename, robot_ids, format);
+    if (!writer.is_open()) {
+        return false;
+    }
+    std::string row(order.size(), 'S');
+    for (size_t t{0}; t < makespan; ++t) {
+        for (size_t l{0}; l < order.size(); ++l) {
+            const auto &moves = move_strings[order[l]].second;
+            row[l] = t < moves.size() ? moves[t] : 'S';
+        }
+        writer.write_row(row.data());
+    }
+    writer.flush();
+    return writer.good();
+}
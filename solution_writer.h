@@ -0,0 +1,76 @@
+#ifndef MAPF_SOLUTION_WRITER_H
+#define MAPF_SOLUTION_WRITER_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum class OutputFormat {
+    Text,  // one line per time step, one action char per robot
+    Binary // 3 bits per action, see SolutionWriter
+};
+
+/* Writes a solution row by row (one action per robot and time step) through a fixed size buffer, so no second copy
+ * of the solution is ever built.
+ *
+ * The binary format starts with the header "MAPF", a version byte (2), the bits per action (3), two zero bytes, the
+ * number of robots as uint32 and their ids as int32, all little endian. Every row follows in ceil(3 * robots / 8)
+ * bytes, the action of the k-th robot in bits [3k, 3k + 3) counted from the lowest bit of the first byte. The codes
+ * are S = 0, U = 1, D = 2, L = 3, R = 4 and 5 for loading or unloading a package (these alternate for every robot).
+ * Each row is followed by the package id byte of every 5 in it, in the order of the robots.
+ */
+class SolutionWriter {
+public:
+    /*
+     * @param robot_ids the robots in the order their actions are passed to write_row
+     */
+    SolutionWriter(const std::string &filename, std::vector<int32_t> robot_ids, OutputFormat format,
+                   size_t buffer_size = size_t{1} << 16u);
+
+    ~SolutionWriter();
+
+    SolutionWriter(const SolutionWriter &) = delete;
+
+    SolutionWriter &operator=(const SolutionWriter &) = delete;
+
+    bool is_open() const;
+
+    /*
+     * @return false if anything written so far could not be handed to the file
+     */
+    bool good() const;
+
+    /*
+     * @param actions one action char per robot
+     */
+    void write_row(const char *actions);
+
+    /*
+     * Hands everything buffered so far to the file.
+     */
+    void flush();
+
+    size_t rows() const noexcept;
+
+private:
+    void append(const char *data, size_t size);
+
+    std::ofstream m_file;
+    std::vector<int32_t> m_robot_ids;
+    OutputFormat m_format;
+    std::vector<char> m_buffer;
+    size_t m_used;
+    size_t m_rows;
+    std::vector<uint8_t> m_packed; // one binary row, followed by its package ids
+};
+
+/*
+ * Writes move_strings (robot id, actions) ordered by robot id. Robots whose actions end early stay where they are.
+ * @return false if the file could not be opened or written
+ */
+bool write_solution(const std::vector<std::pair<int32_t, std::string>> &move_strings, const std::string &filename,
+                    OutputFormat format);
+
+#endif //MAPF_SOLUTION_WRITER_H
@@ -0,0 +1,122 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "input_parsing.h"
+#include "solution_writer.h"
+
+namespace {
+    int failures{0};
+
+    void check(bool condition, const std::string &what) {
+        if (!condition) {
+            std::cerr << "FAILED: " << what << "\n";
+            ++failures;
+        }
+    }
+
+    std::string read_file(const std::string &filename) {
+        std::ifstream in(filename, std::ios::binary);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    uint32_t read_le(const std::string &bytes, size_t at) {
+        uint32_t value{0};
+        for (size_t k{0}; k < 4; ++k) {
+            value |= static_cast<uint32_t>(static_cast<uint8_t>(bytes[at + k])) << (8 * k);
+        }
+        return value;
+    }
+
+    /*
+     * Decodes a binary solution back into one string of action chars per row, see SolutionWriter.
+     */
+    std::vector<std::string> read_binary(const std::string &bytes) {
+        const char codes[] = {'S', 'U', 'D', 'L', 'R'};
+        std::vector<std::string> rows;
+        if (bytes.size() < 12 || bytes.compare(0, 4, "MAPF") != 0 || bytes[4] != 2 || bytes[5] != 3) {
+            return rows;
+        }
+        const auto robots = read_le(bytes, 8);
+        const auto row_bytes = (3 * size_t{robots} + 7) / 8;
+        size_t at = 12 + 4 * size_t{robots};
+        while (at + row_bytes <= bytes.size()) {
+            const auto packed = at;
+            at += row_bytes;
+            std::string row;
+            for (size_t k{0}; k < robots; ++k) {
+                const auto bit = 3 * k;
+                uint32_t code = static_cast<uint8_t>(bytes[packed + bit / 8]);
+                if (bit / 8 + 1 < row_bytes) {
+                    code |= static_cast<uint32_t>(static_cast<uint8_t>(bytes[packed + bit / 8 + 1])) << 8u;
+                }
+                code = (code >> (bit % 8)) & 7u;
+                if (code < 5) {
+                    row += codes[code];
+                } else if (at < bytes.size()) {
+                    row += bytes[at++];
+                }
+            }
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+    void test_round_trip(OutputFormat format, const std::string &filename) {
+        const std::vector<std::pair<int32_t, std::string>> moves{{7, "RRaDDaSS"}, {2, "LbUUUUbLL"}, {3, "cSc"}};
+        check(write_solution(moves, filename, format), "write_solution succeeds");
+        // columns ordered by robot id, robots that are done stay
+        const std::vector<std::string> expected{"LcR", "bSR", "Uca", "USD", "USD", "USa", "bSS", "LSS", "LSS"};
+        std::vector<std::string> rows;
+        if (format == OutputFormat::Binary) {
+            rows = read_binary(read_file(filename));
+        } else {
+            const auto text = read_file(filename);
+            for (size_t begin{0}, end; (end = text.find('\n', begin)) != std::string::npos; begin = end + 1) {
+                rows.push_back(text.substr(begin, end - begin));
+            }
+        }
+        check(rows == expected, std::string(format == OutputFormat::Binary ? "binary" : "text")
+                                + " solution reads back as written");
+        std::remove(filename.c_str());
+    }
+
+    void test_bad_ids_rejected(const std::string &filename) {
+        const std::string grid{"#####\n#A_B#\n#0..#\n#####\ncharge 10\npackages\n"};
+        Instance inst;
+        {
+            std::ofstream out(filename);
+            out << grid << "a A B\n";
+        }
+        check(parse_instance(filename, inst), "an instance with package id a is accepted");
+        {
+            std::ofstream out(filename);
+            out << grid << "S A B\n";
+        }
+        Instance rejected;
+        check(!parse_instance(filename, rejected), "an instance with package id S is rejected");
+        std::remove(filename.c_str());
+
+        Delivery d{};
+        for (const auto id : {"S", "U", "D", "L", "R", "ab"}) {
+            check(!parse_delivery(std::string(id) + " A B", inst, d), std::string("package id ") + id + " is rejected");
+        }
+    }
+}
+
+int main() {
+    const std::string temp = "mapf_solution_writer_test.tmp";
+    test_round_trip(OutputFormat::Text, temp);
+    test_round_trip(OutputFormat::Binary, temp);
+    test_bad_ids_rejected(temp);
+    if (failures > 0) {
+        std::cerr << failures << " checks failed\n";
+        return 1;
+    }
+    std::cout << "all checks passed\n";
+    return 0;
+}
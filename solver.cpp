@@ -0,0 +1,381 @@
+#include "solver.h"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+#include <random>
+
+#include "delivery_planning.h"
+#include "distance_table.h"
+#include "hpa.h"
+#include "reservation_table.h"
+#include "search_context.h"
+#include "search_policies.h"
+#include "sipp.h"
+#include "stats.h"
+#include "task_allocation.h"
+#include "thread_pool.h"
+
+namespace {
+    bool is_avail(SpaceTimePoint p, const ReservationTable &reservations) {
+        return reservations.is_free_around(p);
+    }
+}
+
+PathPlanner select_planner(PlannerKind kind) {
+    switch (kind) {
+        case PlannerKind::Sipp:
+            return sipp;
+        case PlannerKind::Hierarchical:
+            return a_star_hierarchical;
+        case PlannerKind::AStar:
+            break;
+    }
+    return a_star;
+}
+
+bool solve_prioritized(const Instance &inst, const DistanceTable &distances, const Options &options,
+                       ThreadPool &pool, MoveStrings &move_strings) {
+    SolveVariant variant;
+    variant.seed = std::random_device{}();
+    return solve_prioritized(inst, distances, options, pool, variant, move_strings);
+}
+
+bool solve_prioritized(const Instance &inst, const DistanceTable &distances, const Options &options,
+                       ThreadPool &pool, const SolveVariant &variant, MoveStrings &move_strings) {
+    std::vector<RobotState> robot_endpoints;
+    for (const auto &p : inst.robot_positions) {
+        robot_endpoints.push_back({p.first, inst.charge, SpaceTimePoint(p.second)});
+    }
+
+    std::mt19937 rng{variant.seed};
+    const auto stopped = [&variant]() {
+        return variant.stop && variant.stop->load(std::memory_order_relaxed);
+    };
+    const auto time_comp = [&variant](const RobotState &r1, const RobotState &r2) {
+        if (r1.endpoint.t != r2.endpoint.t) {
+            return r1.endpoint.t < r2.endpoint.t;
+        }
+        switch (variant.tie_break) {
+            case TieBreak::LowestId:
+                return r1.id < r2.id;
+            case TieBreak::MostCharge:
+                return r1.charge > r2.charge;
+            default:
+                return false;
+        }
+    };
+
+    // in the order of inst.robot_positions, so the grid finds the string of a robot by its id
+    move_strings.clear();
+    for (const auto &p : inst.robot_positions) {
+        move_strings.emplace_back(p.first, std::string{});
+    }
+    const auto &grid = *distances.grid();
+
+    ReservationTable reservations(distances.grid()); // points in time which are occupied
+    const PathPlanner plan_path = select_planner(options.planner);
+    std::vector<DeliveryPlan> candidate_plans(robot_endpoints.size());
+    std::vector<char> candidate_found(robot_endpoints.size());
+    std::vector<int32_t> candidate_bounds(robot_endpoints.size());
+    std::vector<size_t> candidate_order;
+
+    std::vector<DeliveryTask> tasks;
+    std::vector<size_t> task_delivery; // index into inst.deliveries per task
+    std::vector<Assignment> assignments;
+    {
+        PhaseTimer timer(Phase::Allocation);
+        for (size_t k{0}; k < inst.deliveries.size(); ++k) {
+            const auto d = variant.delivery_order.empty() ? k : variant.delivery_order[k];
+            tasks.push_back(make_delivery_task(inst.deliveries[d], inst, distances));
+            task_delivery.push_back(d);
+        }
+        assignments = allocate_deliveries(options.allocation, robot_endpoints, tasks, distances);
+    }
+    auto &stats = thread_stats();
+    Routes routes(inst.robot_positions.size());
+
+    // Keep delivering
+    for (const auto &assignment : assignments) {
+        if (stopped()) {
+            return false;
+        }
+        PhaseTimer timer(Phase::DeliveryPlanning);
+        ++stats.deliveries;
+        const auto &task = tasks[assignment.delivery];
+        // Order robots by who is out of work first
+        if (variant.tie_break == TieBreak::Random) {
+            std::shuffle(robot_endpoints.begin(), robot_endpoints.end(), rng);
+        }
+        std::stable_sort(robot_endpoints.begin(), robot_endpoints.end(), time_comp);
+
+        for (size_t i{0}; i < robot_endpoints.size(); ++i) {
+            candidate_bounds[i] = delivery_lower_bound(robot_endpoints[i], task, inst, distances);
+        }
+
+        size_t best = robot_endpoints.size();
+        // Try the robot the allocation picked first, only look at the others if that one can't make it
+        for (size_t i{0}; i < robot_endpoints.size(); ++i) {
+            if (robot_endpoints[i].id == assignment.robot_id) {
+                if (candidate_bounds[i] >= 0
+                    && plan_delivery(robot_endpoints[i], task, inst, distances, reservations, plan_path,
+                                     default_search_context(), candidate_plans[i])) {
+                    best = i;
+                } else {
+                    ++stats.failed_candidates;
+                }
+            }
+        }
+
+        if (best == robot_endpoints.size()) {
+            // Take the robot that is done first, on ties the one that has been idle the longest. Robots are planned
+            // for in the order of their lower bounds, once the next bound is past the best plan no one left can win.
+            candidate_order.clear();
+            for (size_t i{0}; i < robot_endpoints.size(); ++i) {
+                if (candidate_bounds[i] >= 0) {
+                    candidate_order.push_back(i);
+                } else {
+                    ++stats.failed_candidates;
+                }
+            }
+            std::stable_sort(candidate_order.begin(), candidate_order.end(), [&candidate_bounds](size_t i1, size_t i2) {
+                return candidate_bounds[i1] < candidate_bounds[i2];
+            });
+
+            size_t next{0};
+            while (next < candidate_order.size() && (best == robot_endpoints.size()
+                                                     || candidate_bounds[candidate_order[next]]
+                                                        <= candidate_plans[best].endpoint.t)) {
+                // The reservations don't change while we look for a robot, so one robot per thread can be planned for
+                const auto count = std::min(pool.size(), candidate_order.size() - next);
+                pool.parallel_for(count, [&](size_t k) {
+                    const auto i = candidate_order[next + k];
+                    candidate_found[i] = plan_delivery(robot_endpoints[i], task, inst, distances, reservations,
+                                                       plan_path, default_search_context(), candidate_plans[i]);
+                });
+                for (size_t k{0}; k < count; ++k) {
+                    const auto i = candidate_order[next + k];
+                    if (!candidate_found[i]) {
+                        ++stats.failed_candidates;
+                        continue;
+                    }
+                    const auto t = candidate_plans[i].endpoint.t;
+                    if (best == robot_endpoints.size() || t < candidate_plans[best].endpoint.t
+                        || (t == candidate_plans[best].endpoint.t && i < best)) {
+                        best = i;
+                    }
+                }
+                next += count;
+            }
+            stats.pruned_candidates += candidate_order.size() - next;
+        }
+
+        // We didn't find any good robot. Nooo!
+        if (best == robot_endpoints.size()) {
+            if (variant.verbose) {
+                std::cout << "No solution\n";
+            }
+            return false;
+        }
+
+        const auto &plan = candidate_plans[best];
+        reserve_delivery(plan, reservations);
+        // Assign a new position + charge to our robot
+        robot_endpoints[best].charge = plan.charge;
+        robot_endpoints[best].endpoint = plan.endpoint;
+
+        move_strings[static_cast<size_t>(grid.robot_index(plan.robot_id))].second += delivery_to_string(plan);
+        routes[static_cast<size_t>(grid.robot_index(plan.robot_id))].deliveries.push_back(
+                task_delivery[assignment.delivery]);
+    }
+    for (const auto &r : robot_endpoints) {
+        routes[static_cast<size_t>(grid.robot_index(r.id))].end = r;
+    }
+
+    if (variant.verbose) {
+        std::cout << "All packages delivered, now fill 'meaningless' actions for robots to let others deliver.\n";
+    }
+
+    const auto max_length = makespan(move_strings);
+
+    PhaseTimer timer(Phase::IdleFilling);
+    for (const auto &r : robot_endpoints) {
+        if (stopped()) {
+            return false;
+        }
+        const auto end_time = r.endpoint.t;
+        const auto robot_id = r.id;
+
+        if (static_cast<size_t>(end_time) < max_length) {
+            const auto needed_steps = max_length - end_time - 1;
+            const auto start = r.endpoint;
+            const auto charge = r.charge;
+            ++stats.idle_robots;
+
+            CompactPath rest_path;
+            if (!find_actions(start, charge, needed_steps, reservations, rng, rest_path)) {
+                if (variant.verbose) {
+                    std::cout << "Not all robots could manage to evade the rest of the pack while no longer needed.\n";
+                    std::cout << "A solution might be found if we get permission to blow up robots that are past "
+                                 "their use\n";
+                }
+                return false;
+            } else {
+                for (const auto &p : rest_path) {
+                    reservations.reserve(p);
+                }
+                rest_path.append_actions(move_strings[static_cast<size_t>(grid.robot_index(robot_id))].second);
+            }
+        }
+    }
+
+    if (variant.routes) {
+        variant.routes->swap(routes);
+    }
+    return true;
+}
+
+size_t makespan(const MoveStrings &move_strings) {
+    size_t longest{0};
+    for (const auto &m : move_strings) {
+        longest = std::max(longest, m.second.length());
+    }
+    return longest;
+}
+
+void print_solution(const MoveStrings &move_strings) {
+    std::cout << "Final movements:\n";
+    size_t makespan{0};
+    size_t total_moves{0};
+    for (const auto &m : move_strings) {
+        std::cout << "id: " << m.first << ", str: " << m.second << "\n";
+        makespan = std::max(makespan, m.second.length());
+        total_moves += std::count_if(m.second.begin(), m.second.end(), [](const char c) {
+            return c == 'U' || c == 'D' || c == 'L' || c == 'R';
+        });
+    }
+    std::cout << "Makespan: " << makespan << ", total moves: " << total_moves << "\n";
+}
+
+bool find_actions(SpaceTimePoint start, int32_t charge, int32_t needed_steps, const ReservationTable &reservations,
+                  std::mt19937 &rng, CompactPath &path) {
+    path.clear();
+    if (charge < 0) {
+        return false;
+    }
+    const int32_t end = start.t + std::max(needed_steps + 1, 0);
+    // start is reserved by the robot itself, so staying there one more step only needs the field to be free after
+    const auto can_stay_at_start = [&reservations, start]() {
+        return reservations.is_free(start.x, start.y, start.t + 1) && reservations.is_free(start.x, start.y,
+                                                                                           start.t + 2);
+    };
+    // waiting on (x, y) from t to end is safe if nothing comes by until then
+    const auto can_park = [&reservations, end](int32_t x, int32_t y, int32_t t) {
+        return reservations.next_blocked(x, y, t) > end;
+    };
+    const auto wait_until_end = [&path, end]() {
+        while (path.back().t < end) {
+            path.push_back(Move::Rest);
+        }
+    };
+
+    path.push_back(start);
+    if (can_stay_at_start() && can_park(start.x, start.y, start.t + 2)) {
+        wait_until_end();
+        return true;
+    }
+
+    // Forward reachability over (cell, t), one layer per time step. Of all ways to a cell at t only the one with the
+    // most charge left is kept, nothing else matters for the future, so a layer never has more nodes than cells.
+    // Only the last layer is kept as nodes, of all layers just the way back: per node the index of its parent in the
+    // layer before and the move from there, five bytes per node instead of a whole node.
+    struct IdleNode {
+        int32_t x;
+        int32_t y;
+        int32_t charge;
+    };
+    const auto &grid = reservations.grid();
+    const auto width = grid.width();
+    std::vector<IdleNode> layer{{start.x, start.y, charge}};
+    std::vector<IdleNode> next;
+    std::vector<uint32_t> parents{0};
+    std::vector<uint8_t> moves_from{static_cast<uint8_t>(Move::Rest)};
+    std::vector<size_t> layer_begins{0}; // per step after start.t, where its layer starts in parents and moves_from
+    std::vector<int32_t> in_layer(grid.cells(), -1);
+    // per cell the last next_blocked found there, parking can't work there before the robot gets past it
+    std::vector<int32_t> blocked_at(grid.cells(), -1);
+
+    const auto reconstruct = [&](size_t index, int32_t t) {
+        path = CompactPath(start, static_cast<size_t>(t - start.t));
+        for (; t > start.t; --t) {
+            const auto node = layer_begins[static_cast<size_t>(t - start.t)] + index;
+            path.set_move(static_cast<size_t>(t - 1 - start.t), static_cast<Move>(moves_from[node]));
+            index = parents[node];
+        }
+    };
+
+    const GridNeighbourhood<ReservationTable> neighbourhood(reservations);
+    std::array<SpacePoint, 4> moves{{{0, 0}, {0, 0}, {0, 0}, {0, 0}}};
+    for (auto t = start.t + 1; t <= end; ++t) {
+        const auto begin = parents.size();
+        layer_begins.push_back(begin);
+        next.clear();
+        for (size_t index{0}; index < layer.size(); ++index) {
+            const auto curr = layer[index];
+            const auto reach = [&](int32_t x, int32_t y, int32_t new_charge) {
+                const bool free = t == start.t + 1 && x == start.x && y == start.y ? can_stay_at_start()
+                                                                                   : is_avail(SpaceTimePoint(x, y, t),
+                                                                                              reservations);
+                if (new_charge < 0 || !free) {
+                    return;
+                }
+                const auto move = static_cast<uint8_t>(move_between(SpaceTimePoint(curr.x, curr.y, t - 1),
+                                                                    SpaceTimePoint(x, y, t)));
+                auto &slot = in_layer[static_cast<size_t>(y) * width + x];
+                if (slot < 0) {
+                    slot = static_cast<int32_t>(next.size());
+                    next.push_back({x, y, new_charge});
+                    parents.push_back(static_cast<uint32_t>(index));
+                    moves_from.push_back(move);
+                } else if (new_charge > next[slot].charge) {
+                    next[slot].charge = new_charge;
+                    parents[begin + slot] = static_cast<uint32_t>(index);
+                    moves_from[begin + slot] = move;
+                }
+            };
+
+            // staying is tried first, the moves the grid allows in a random (but seeded) order
+            reach(curr.x, curr.y, curr.charge);
+            const auto count = neighbourhood.moves(curr.x, curr.y, moves);
+            std::shuffle(moves.begin(), moves.begin() + static_cast<std::ptrdiff_t>(count), rng);
+            for (size_t k{0}; k < count; ++k) {
+                reach(moves[k].x, moves[k].y, curr.charge - 1);
+            }
+        }
+        if (next.empty()) {
+            path.clear();
+            return false;
+        }
+
+        for (size_t index{0}; index < next.size(); ++index) {
+            const auto &n = next[index];
+            const auto cell = static_cast<size_t>(n.y) * width + n.x;
+            in_layer[cell] = -1;
+            // a cell is checked for parking again once the robot could be there after the block found last time,
+            // a field passed by another robot early on may well be free for good later
+            if (t + 1 > blocked_at[cell]) {
+                blocked_at[cell] = reservations.next_blocked(n.x, n.y, t + 1);
+                if (blocked_at[cell] > end) {
+                    reconstruct(index, t);
+                    wait_until_end();
+                    return true;
+                }
+            }
+        }
+        std::swap(layer, next);
+    }
+
+    // every node of the last layer made it to the end
+    reconstruct(0, end);
+    return true;
+}
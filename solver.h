@@ -0,0 +1,93 @@
+#ifndef MAPF_SOLVER_H
+#define MAPF_SOLVER_H
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "compact_path.h"
+#include "delivery_planning.h"
+#include "input_parsing.h"
+#include "options.h"
+#include "pathfinding.h"
+
+class DistanceTable;
+class ReservationTable;
+class ThreadPool;
+
+/* The actions of every robot in the output alphabet, one string per robot id.
+ */
+using MoveStrings = std::vector<std::pair<int32_t, std::string>>;
+
+/* The work of a robot in a solution: the deliveries it does and where it is done with them. Its move string up to
+ * end.endpoint.t holds those deliveries, the rest only keeps it out of the way.
+ */
+struct RobotRoute {
+    std::vector<size_t> deliveries; // indices into inst.deliveries, in the order they are done
+    RobotState end;
+};
+
+/* One route per robot, in the same order as the move strings.
+ */
+using Routes = std::vector<RobotRoute>;
+
+/* Which robot is tried first among those that are out of work at the same time.
+ */
+enum class TieBreak {
+    Stable,     // the one that has been idle the longest
+    LowestId,
+    MostCharge,
+    Random
+};
+
+/* Everything a prioritized solve may be varied in, the defaults give the plain solve.
+ */
+struct SolveVariant {
+    std::vector<size_t> delivery_order; // permutation of inst.deliveries handed to the allocation, empty for file order
+    TieBreak tie_break{TieBreak::Stable};
+    uint32_t seed{0}; // for the random tie break and find_actions
+    const std::atomic<bool> *stop{nullptr}; // if set the solve gives up as soon as it is true
+    bool verbose{true}; // print progress and the reason of a failure
+    Routes *routes{nullptr}; // if set it receives the route of every robot of the solution
+};
+
+PathPlanner select_planner(PlannerKind kind);
+
+/*
+ * Prioritized planning: deliveries are planned one after another around the reservations of all earlier ones, robots
+ * that are done early keep out of the way until the last one is finished. Uses a random seed.
+ * @return false if no solution was found, the reason has been printed already
+ */
+bool solve_prioritized(const Instance &inst, const DistanceTable &distances, const Options &options,
+                       ThreadPool &pool, MoveStrings &move_strings);
+
+/*
+ * Same as above, with the delivery order, tie break and seed taken from variant.
+ * @return false if no solution was found or the solve was stopped
+ */
+bool solve_prioritized(const Instance &inst, const DistanceTable &distances, const Options &options,
+                       ThreadPool &pool, const SolveVariant &variant, MoveStrings &move_strings);
+
+/*
+ * Finds needed_steps + 1 actions from start that stay clear of the reservations, used to keep robots that are done
+ * out of the way. Moves cost one charge each. If the robot can simply wait somewhere until the end it goes to the
+ * first such field it reaches, otherwise a layered reachability search over (cell, time) finds any way through, in
+ * O(cells * steps) at worst. Moves are tried in a random order, the same rng state gives the same walk.
+ * @return false if there is none, otherwise path holds the walk from start on, one point per time step
+ */
+bool find_actions(SpaceTimePoint start, int32_t charge, int32_t needed_steps, const ReservationTable &reservations,
+                  std::mt19937 &rng, CompactPath &path);
+
+/*
+ * @return the length of the longest move string
+ */
+size_t makespan(const MoveStrings &move_strings);
+
+/*
+ * Prints the actions of every robot and the makespan and number of moves of the solution.
+ */
+void print_solution(const MoveStrings &move_strings);
+
+#endif //MAPF_SOLVER_H
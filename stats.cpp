@@ -0,0 +1,158 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+#include "search_context.h"
+
+namespace {
+    /* All live per thread stats, and the sum of those whose threads are gone.
+     */
+    struct Registry {
+        std::mutex mutex;
+        std::vector<const Stats *> live;
+        Stats retired;
+    };
+
+    Registry &registry() {
+        static Registry r;
+        return r;
+    }
+
+    /* The per thread instance, it registers on the first use in a thread and hands its counts over when the thread
+     * ends.
+     */
+    struct ThreadStats {
+        ThreadStats() {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            registry().live.push_back(&stats);
+        }
+
+        ~ThreadStats() {
+            std::lock_guard<std::mutex> lock(registry().mutex);
+            auto &live = registry().live;
+            live.erase(std::remove(live.begin(), live.end(), &stats), live.end());
+            registry().retired += stats;
+        }
+
+        Stats stats;
+    };
+
+    const char *phase_name(Phase phase) {
+        switch (phase) {
+            case Phase::Parse:
+                return "parse";
+            case Phase::Preprocess:
+                return "preprocess";
+            case Phase::Allocation:
+                return "allocation";
+            case Phase::DeliveryPlanning:
+                return "delivery_planning";
+            case Phase::IdleFilling:
+                return "idle_filling";
+            case Phase::Cbs:
+                return "cbs";
+            case Phase::Portfolio:
+                return "portfolio";
+            case Phase::Windowed:
+                return "windowed";
+            case Phase::Improvement:
+                return "improvement";
+            case Phase::Output:
+                return "output";
+            case Phase::Count:
+                break;
+        }
+        return "unknown";
+    }
+}
+
+Stats &Stats::operator+=(const Stats &other) {
+    searches += other.searches;
+    failed_searches += other.failed_searches;
+    nodes_expanded += other.nodes_expanded;
+    nodes_generated += other.nodes_generated;
+    reservation_lookups += other.reservation_lookups;
+    heuristic_cutoffs += other.heuristic_cutoffs;
+    deliveries += other.deliveries;
+    failed_candidates += other.failed_candidates;
+    pruned_candidates += other.pruned_candidates;
+    idle_robots += other.idle_robots;
+    for (size_t k{0}; k < phase_seconds.size(); ++k) {
+        phase_seconds[k] += other.phase_seconds[k];
+    }
+    return *this;
+}
+
+Stats &thread_stats() {
+    thread_local ThreadStats s;
+    return s.stats;
+}
+
+Stats collect_stats() {
+    // make sure the calling thread is part of the sum even if it never counted anything
+    thread_stats();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    Stats sum = registry().retired;
+    for (const auto *s : registry().live) {
+        sum += *s;
+    }
+    return sum;
+}
+
+bool write_stats(const Stats &stats, const std::string &filename) {
+    std::ofstream out(filename);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    const auto per = [](uint64_t count, uint64_t total) {
+        return total == 0 ? 0.0 : static_cast<double>(count) / static_cast<double>(total);
+    };
+    out << "{\n";
+    out << "  \"searches\": " << stats.searches << ",\n";
+    out << "  \"failed_searches\": " << stats.failed_searches << ",\n";
+    out << "  \"nodes_expanded\": " << stats.nodes_expanded << ",\n";
+    out << "  \"nodes_generated\": " << stats.nodes_generated << ",\n";
+    out << "  \"nodes_expanded_per_search\": " << per(stats.nodes_expanded, stats.searches) << ",\n";
+    out << "  \"nodes_generated_per_search\": " << per(stats.nodes_generated, stats.searches) << ",\n";
+    out << "  \"reservation_lookups\": " << stats.reservation_lookups << ",\n";
+    out << "  \"heuristic_cutoffs\": " << stats.heuristic_cutoffs << ",\n";
+    out << "  \"deliveries\": " << stats.deliveries << ",\n";
+    out << "  \"failed_candidates\": " << stats.failed_candidates << ",\n";
+    out << "  \"failed_candidates_per_delivery\": " << per(stats.failed_candidates, stats.deliveries) << ",\n";
+    out << "  \"pruned_candidates\": " << stats.pruned_candidates << ",\n";
+    out << "  \"idle_robots\": " << stats.idle_robots << ",\n";
+    out << "  \"seconds_per_delivery\": "
+        << (stats.deliveries == 0 ? 0.0 : stats.phase_seconds[static_cast<size_t>(Phase::DeliveryPlanning)]
+                                          / static_cast<double>(stats.deliveries)) << ",\n";
+    out << "  \"phase_seconds\": {";
+    for (size_t k{0}; k < stats.phase_seconds.size(); ++k) {
+        out << (k == 0 ? "\n" : ",\n") << "    \"" << phase_name(static_cast<Phase>(k)) << "\": "
+            << stats.phase_seconds[k];
+    }
+    out << "\n  }\n";
+    out << "}\n";
+    return out.good();
+}
+
+PhaseTimer::PhaseTimer(Phase phase) : m_phase(phase), m_begin(std::chrono::steady_clock::now()) {}
+
+PhaseTimer::~PhaseTimer() {
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_begin;
+    thread_stats().phase_seconds[static_cast<size_t>(m_phase)] += elapsed.count();
+}
+
+SearchRecorder::SearchRecorder(const SearchContext &context) : m_context(context) {}
+
+SearchRecorder::~SearchRecorder() {
+    auto &stats = thread_stats();
+    ++stats.searches;
+    stats.failed_searches += found ? 0 : 1;
+    stats.nodes_expanded += expanded;
+    stats.nodes_generated += m_context.size();
+    stats.reservation_lookups += lookups;
+    stats.heuristic_cutoffs += cut_off ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+#ifndef MAPF_STATS_H
+#define MAPF_STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+class SearchContext;
+
+enum class Phase {
+    Parse, Preprocess, Allocation, DeliveryPlanning, IdleFilling, Cbs, Portfolio, Windowed, Improvement, Output, Count
+};
+
+/* Counters and timers of a run. Every thread counts into its own instance, see thread_stats, so the planners never
+ * have to lock.
+ */
+struct Stats {
+    Stats &operator+=(const Stats &other);
+
+    uint64_t searches{0};
+    uint64_t failed_searches{0};
+    uint64_t nodes_expanded{0};
+    uint64_t nodes_generated{0};
+    uint64_t reservation_lookups{0};
+    uint64_t heuristic_cutoffs{0}; // a_star gave up as the robot would wait too long
+    uint64_t deliveries{0};
+    uint64_t failed_candidates{0}; // robots that could not do a delivery they were tried for
+    uint64_t pruned_candidates{0}; // robots not planned for as their lower bound could not beat the best plan
+    uint64_t idle_robots{0}; // robots whose remaining time find_actions had to fill
+    std::array<double, static_cast<size_t>(Phase::Count)> phase_seconds{};
+};
+
+/*
+ * @return the stats of the calling thread
+ */
+Stats &thread_stats();
+
+/*
+ * Sums the stats of all threads, including those that have ended already. Only call while no other thread is
+ * counting, e.g. after the thread pool is done.
+ */
+Stats collect_stats();
+
+/*
+ * Writes stats as a JSON object.
+ * @return false if the file could not be opened
+ */
+bool write_stats(const Stats &stats, const std::string &filename);
+
+/* Adds the time from construction to destruction to a phase of the calling thread.
+ */
+class PhaseTimer {
+public:
+    explicit PhaseTimer(Phase phase);
+
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer &) = delete;
+
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+    Phase m_phase;
+    std::chrono::steady_clock::time_point m_begin;
+};
+
+/* Counts a single search of a planner into the stats of the calling thread once it goes out of scope, so every return
+ * of the planner is covered. The planner counts into the public members while it searches.
+ */
+class SearchRecorder {
+public:
+    explicit SearchRecorder(const SearchContext &context);
+
+    ~SearchRecorder();
+
+    SearchRecorder(const SearchRecorder &) = delete;
+
+    SearchRecorder &operator=(const SearchRecorder &) = delete;
+
+    uint64_t expanded{0};
+    uint64_t lookups{0};
+    bool cut_off{false};
+    bool found{false};
+
+private:
+    const SearchContext &m_context;
+};
+
+#endif //MAPF_STATS_H
@@ -0,0 +1,321 @@
+#include "stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "delivery_planning.h"
+#include "distance_table.h"
+#include "reservation_table.h"
+#include "search_context.h"
+#include "solution_writer.h"
+#include "solver.h"
+
+namespace {
+    /* A robot of the running simulation. Its actions from time base on are in moves, afterwards it is parked on the
+     * field of state.endpoint.
+     */
+    struct StreamRobot {
+        RobotState state;
+        SpacePoint home;
+        int32_t base;
+        std::string moves;
+    };
+
+    // chargers besides home and the end of a delivery that are tried for parking, each one costs a search
+    constexpr size_t parking_chargers{3};
+
+    /* Splits what arrives on a file descriptor into lines.
+     */
+    class LineReader {
+    public:
+        explicit LineReader(int fd) : m_fd(fd), m_eof(false) {}
+
+        bool eof() const {
+            return m_eof;
+        }
+
+        /*
+         * Waits at most timeout_ms (forever if negative) for input and reads what is there.
+         * @return the complete lines read, an unterminated last line is only returned at the end of the stream
+         */
+        std::vector<std::string> read_lines(int timeout_ms) {
+            std::vector<std::string> lines;
+            pollfd p{m_fd, POLLIN, 0};
+            if (poll(&p, 1, timeout_ms) <= 0) {
+                return lines;
+            }
+
+            char buffer[4096];
+            const auto n = read(m_fd, buffer, sizeof(buffer));
+            if (n <= 0) {
+                m_eof = true;
+                if (!m_pending.empty()) {
+                    lines.push_back(m_pending);
+                    m_pending.clear();
+                }
+                return lines;
+            }
+            m_pending.append(buffer, static_cast<size_t>(n));
+            for (auto end = m_pending.find('\n'); end != std::string::npos; end = m_pending.find('\n')) {
+                lines.push_back(m_pending.substr(0, end));
+                m_pending.erase(0, end + 1);
+            }
+            return lines;
+        }
+
+    private:
+        int m_fd;
+        bool m_eof;
+        std::string m_pending;
+    };
+
+    /* Plans deliveries at the current time for the robot that finishes first, and sends it home afterwards.
+     */
+    class StreamPlanner {
+    public:
+        StreamPlanner(const Instance &inst, const DistanceTable &distances, PathPlanner plan_path)
+                : m_inst(inst), m_distances(distances), m_plan_path(plan_path),
+                  m_reservations(distances.grid()) {
+            for (const auto &p : inst.robot_positions) {
+                m_robots.push_back({{p.first, inst.charge, SpaceTimePoint(p.second)}, p.second, 0, std::string{}});
+                m_reservations.park(p.second.x, p.second.y, 0);
+            }
+            std::sort(m_robots.begin(), m_robots.end(), [](const StreamRobot &r1, const StreamRobot &r2) {
+                return r1.state.id < r2.state.id;
+            });
+        }
+
+        /*
+         * @return false if no robot can do d starting at now and park afterwards
+         */
+        bool plan(const Delivery &d, int32_t now) {
+            const auto task = make_delivery_task(d, m_inst, m_distances);
+
+            // every robot has to be unparked to plan from its field, so the candidates are planned one at a time
+            std::vector<std::pair<size_t, DeliveryPlan>> candidates;
+            DeliveryPlan plan{};
+            for (size_t i{0}; i < m_robots.size(); ++i) {
+                const auto &state = m_robots[i].state;
+                m_reservations.unpark(state.endpoint.x, state.endpoint.y);
+                if (plan_delivery(departure(state, now), task, m_inst, m_distances, m_reservations, m_plan_path,
+                                  default_search_context(), plan)) {
+                    candidates.emplace_back(i, plan);
+                }
+                m_reservations.park(state.endpoint.x, state.endpoint.y, state.endpoint.t);
+            }
+            std::stable_sort(candidates.begin(), candidates.end(), [](const auto &c1, const auto &c2) {
+                return c1.second.endpoint.t < c2.second.endpoint.t;
+            });
+
+            // the robot done first gets the delivery, unless it has nowhere to park afterwards
+            for (const auto &candidate : candidates) {
+                auto &robot = m_robots[candidate.first];
+                const auto &best_plan = candidate.second;
+                m_reservations.unpark(robot.state.endpoint.x, robot.state.endpoint.y);
+                CompactPath to_parking;
+                if (!find_parking(best_plan, robot.home, to_parking)) {
+                    m_reservations.park(robot.state.endpoint.x, robot.state.endpoint.y, robot.state.endpoint.t);
+                    continue;
+                }
+
+                const auto start = departure(robot.state, now).endpoint;
+                for (auto t = robot.state.endpoint.t; t <= start.t; ++t) {
+                    m_reservations.reserve(start.x, start.y, t);
+                }
+                reserve_delivery(best_plan, m_reservations);
+                robot.moves.resize(static_cast<size_t>(start.t - robot.base), 'S');
+                robot.moves += delivery_to_string(best_plan);
+                robot.state.charge = best_plan.charge;
+                robot.state.endpoint = best_plan.endpoint;
+                if (!to_parking.empty()) {
+                    for (const auto p : to_parking) {
+                        m_reservations.reserve(p);
+                    }
+                    to_parking.append_actions(robot.moves);
+                    robot.state.charge -= get_used_charge(to_parking);
+                    robot.state.endpoint = to_parking.back();
+                }
+                m_reservations.park(robot.state.endpoint.x, robot.state.endpoint.y, robot.state.endpoint.t);
+                return true;
+            }
+            return false;
+        }
+
+        /*
+         * Writes the rows of all time steps in [from, to) and forgets everything before to.
+         */
+        void emit(int32_t from, int32_t to, SolutionWriter &out) {
+            std::string row(m_robots.size(), 'S');
+            for (auto t = from; t < to; ++t) {
+                for (size_t l{0}; l < m_robots.size(); ++l) {
+                    const auto &r = m_robots[l];
+                    const auto k = static_cast<size_t>(t - r.base);
+                    row[l] = k < r.moves.size() ? r.moves[k] : 'S';
+                }
+                out.write_row(row.data());
+            }
+            out.flush();
+
+            for (auto &r : m_robots) {
+                const auto done = std::min(static_cast<size_t>(to - r.base), r.moves.size());
+                r.moves.erase(0, done);
+                r.base = r.moves.empty() ? to : r.base + static_cast<int32_t>(done);
+            }
+            // a plan starting at to still looks one step back
+            m_reservations.drop_before(to - 1);
+        }
+
+        std::vector<int32_t> robot_ids() const {
+            std::vector<int32_t> ids;
+            for (const auto &r : m_robots) {
+                ids.push_back(r.state.id);
+            }
+            return ids;
+        }
+
+        /*
+         * @return the time at which the last robot is parked
+         */
+        int32_t end() const {
+            int32_t end{0};
+            for (const auto &r : m_robots) {
+                end = std::max(end, r.base + static_cast<int32_t>(r.moves.size()));
+            }
+            return end;
+        }
+
+    private:
+        /*
+         * Looks for a field to park on for good once plan is done: home, else where plan ends, else one of the nearest
+         * chargers. A field only counts if no robot planned so far ever needs it again. Must be called before plan
+         * is reserved, the robot's own reservations would be in its way.
+         * @param way is set to the path there, empty if the robot stays where plan ends
+         * @return false if there is no such field in reach
+         */
+        bool find_parking(const DeliveryPlan &plan, SpacePoint home, CompactPath &way) const {
+            const auto end = plan.endpoint;
+            std::vector<SpacePoint> goals{home, SpacePoint(end)};
+            auto chargers = m_inst.charger_positions;
+            const auto tried = chargers.begin()
+                               + static_cast<std::ptrdiff_t>(std::min(chargers.size(), parking_chargers));
+            std::partial_sort(chargers.begin(), tried, chargers.end(), [this, end](SpacePoint c1, SpacePoint c2) {
+                return m_distances.distance(c1, SpacePoint(end)) < m_distances.distance(c2, SpacePoint(end));
+            });
+            chargers.erase(tried, chargers.end());
+            for (const auto c : chargers) {
+                if (std::find(goals.begin(), goals.end(), c) == goals.end()) {
+                    goals.push_back(c);
+                }
+            }
+
+            for (const auto goal : goals) {
+                if (goal == SpacePoint(end)) {
+                    if (m_reservations.next_blocked(end.x, end.y, end.t) == ReservationTable::never_blocked) {
+                        way = CompactPath{};
+                        return true;
+                    }
+                    continue;
+                }
+                way = m_plan_path(end, goal, 1, plan.charge, m_inst.width, m_inst.height, m_reservations,
+                                  &m_distances, default_search_context());
+                if (!way.empty() && m_reservations.next_blocked(goal.x, goal.y, way.back().t)
+                                    == ReservationTable::never_blocked) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static RobotState departure(const RobotState &state, int32_t now) {
+            auto start = state;
+            start.endpoint.t = std::max(state.endpoint.t, now);
+            return start;
+        }
+
+        const Instance &m_inst;
+        const DistanceTable &m_distances;
+        PathPlanner m_plan_path;
+        ReservationTable m_reservations;
+        std::vector<StreamRobot> m_robots;
+    };
+}
+
+bool run_stream(const Instance &inst, const DistanceTable &distances, const Options &options) {
+    const int fd = options.stream == "-" ? STDIN_FILENO : open(options.stream.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cout << "Cannot open the stream: " << options.stream << "\n";
+        return false;
+    }
+    StreamPlanner planner(inst, distances, select_planner(options.planner));
+    SolutionWriter out(options.output_file, planner.robot_ids(), options.output_format);
+    if (!out.is_open()) {
+        std::cout << "Could not open output filename\n";
+        if (fd != STDIN_FILENO) {
+            close(fd);
+        }
+        return false;
+    }
+
+    LineReader reader(fd);
+    size_t planned{0};
+    size_t skipped{0};
+    const auto plan = [&](const Delivery &d, int32_t now) {
+        if (!planner.plan(d, now)) {
+            std::cout << "No robot can do delivery " << d.id << ", skipped\n";
+            ++skipped;
+        } else {
+            ++planned;
+        }
+    };
+    for (const auto &d : inst.deliveries) {
+        plan(d, 0);
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto step = std::chrono::milliseconds(options.step_ms);
+    const auto begin = Clock::now();
+    int32_t now{0};
+    while (!reader.eof()) {
+        const auto elapsed = Clock::now() - begin;
+        const auto current = static_cast<int32_t>(elapsed / step);
+        if (current > now) {
+            planner.emit(now, current, out);
+            now = current;
+        }
+
+        const auto next_step = std::chrono::duration_cast<std::chrono::milliseconds>(begin + (now + 1) * step
+                                                                                     - Clock::now());
+        for (const auto &line : reader.read_lines(static_cast<int>(std::max<int64_t>(next_step.count(), 0)))) {
+            Delivery d{};
+            if (line.empty()) {
+                continue;
+            }
+            if (!parse_delivery(line, inst, d)) {
+                std::cout << "Invalid delivery: " << line << ", skipped\n";
+                ++skipped;
+                continue;
+            }
+            plan(d, now);
+        }
+    }
+
+    // nothing new will come, write out the remaining work at once
+    const auto end = std::max(now, planner.end());
+    planner.emit(now, end, out);
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+
+    std::cout << "Stream ended after " << end << " time steps, " << planned << " deliveries planned, " << skipped
+              << " skipped\n";
+    if (!out.good()) {
+        std::cout << "Could not write the output file\n";
+        return false;
+    }
+    return true;
+}
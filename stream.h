@@ -0,0 +1,21 @@
+#ifndef MAPF_STREAM_H
+#define MAPF_STREAM_H
+
+#include "input_parsing.h"
+#include "options.h"
+
+class DistanceTable;
+
+/*
+ * Lifelong mode. Time follows the wall clock, one step every options.step_ms. The deliveries of inst are planned at
+ * time 0, afterwards delivery lines are read from options.stream while they arrive and planned at the current time
+ * against the live reservations. Output rows are written as soon as time has passed them, reservations from before
+ * the current time are dropped.
+ *
+ * Robots without work are parked: after a delivery they return to their start field and stay there, which nobody
+ * else needs, until they get the next one. Once the stream ends the remaining work is written and the run is over.
+ * @return false if the stream or the output file could not be opened
+ */
+bool run_stream(const Instance &inst, const DistanceTable &distances, const Options &options);
+
+#endif //MAPF_STREAM_H
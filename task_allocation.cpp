@@ -0,0 +1,326 @@
+#include "task_allocation.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+#include "distance_table.h"
+
+namespace {
+    /* What the allocation knows about a robot: where it will be and when it will be free, both estimated.
+     */
+    struct RobotEstimate {
+        int32_t id;
+        SpacePoint position;
+        int64_t ready;
+    };
+
+    struct TimedAssignment {
+        Assignment assignment;
+        int64_t start;
+    };
+
+    /*
+     * Estimated time from arriving at the start shelf of task to being done with it, including both recharges.
+     */
+    int32_t time_from_start(const DeliveryTask &task, const DistanceTable &distances) {
+        const int32_t to_charger_1 = distances.distance(task.charger_1, task.start);
+        const int32_t to_goal = distances.distance(task.goal, task.charger_1);
+        const int32_t to_charger_2 = distances.distance(task.charger_2, task.goal);
+        // moving, loading and unloading, and recharging the moves made since the last charger
+        return 2 * to_charger_1 + 1 + 2 * (to_goal + to_charger_2) + 1;
+    }
+
+    /* Estimated finish times of every robot for every task. Only the way to the start shelf depends on the robot, and
+     * the tasks share few start shelves, so each robot keeps its distance to every start shelf. Assigning a task to a
+     * robot then costs one lookup per start shelf instead of one per task.
+     */
+    class FinishTimes {
+    public:
+        FinishTimes(std::vector<RobotEstimate> &robots, const std::vector<DeliveryTask> &tasks,
+                    const DistanceTable &distances)
+                : m_robots(robots), m_tasks(tasks), m_distances(distances), m_start_of(tasks.size()),
+                  m_time_from_start(tasks.size()) {
+            std::unordered_map<int64_t, size_t> start_index; // by the field of the shelf
+            for (size_t d{0}; d < tasks.size(); ++d) {
+                const auto field = int64_t{tasks[d].start.y} * distances.width() + tasks[d].start.x;
+                const auto known = start_index.emplace(field, m_starts.size());
+                if (known.second) {
+                    m_starts.push_back(tasks[d].start);
+                }
+                m_start_of[d] = known.first->second;
+                m_time_from_start[d] = time_from_start(tasks[d], distances);
+            }
+            m_to_start.resize(robots.size() * m_starts.size());
+            for (size_t r{0}; r < robots.size(); ++r) {
+                update(r);
+            }
+        }
+
+        int64_t operator()(size_t robot, size_t delivery) const {
+            return m_robots[robot].ready + 2 * m_to_start[robot * m_starts.size() + m_start_of[delivery]]
+                   + m_time_from_start[delivery];
+        }
+
+        /*
+         * Gives delivery to robot, which is busy with it until its finish time and ends up at its second charger.
+         */
+        void assign(size_t robot, size_t delivery, std::vector<TimedAssignment> &result) {
+            auto &r = m_robots[robot];
+            result.push_back({{delivery, r.id}, r.ready});
+            r.ready = (*this)(robot, delivery);
+            r.position = m_tasks[delivery].charger_2;
+            update(robot);
+        }
+
+    private:
+        void update(size_t robot) {
+            for (size_t s{0}; s < m_starts.size(); ++s) {
+                m_to_start[robot * m_starts.size() + s] = m_distances.distance(m_starts[s], m_robots[robot].position);
+            }
+        }
+
+        std::vector<RobotEstimate> &m_robots;
+        const std::vector<DeliveryTask> &m_tasks;
+        const DistanceTable &m_distances;
+        std::vector<SpacePoint> m_starts; // the distinct start shelves
+        std::vector<size_t> m_start_of; // per task, index into m_starts
+        std::vector<int32_t> m_time_from_start; // per task
+        std::vector<int32_t> m_to_start; // per robot and start shelf
+    };
+
+    struct Bid {
+        int64_t finish;
+        size_t robot;
+    };
+
+    std::vector<TimedAssignment> auction(std::vector<RobotEstimate> &robots, const std::vector<DeliveryTask> &tasks,
+                                         const DistanceTable &distances) {
+        FinishTimes finish_time(robots, tasks, distances);
+        const auto best_bid = [&robots, &finish_time](size_t d) {
+            Bid best{std::numeric_limits<int64_t>::max(), 0};
+            for (size_t r{0}; r < robots.size(); ++r) {
+                const auto finish = finish_time(r, d);
+                if (finish < best.finish) {
+                    best = {finish, r};
+                }
+            }
+            return best;
+        };
+
+        // the best bid per delivery only changes where the robot that just won bids, so only that is looked at
+        std::vector<Bid> best(tasks.size());
+        for (size_t d{0}; d < tasks.size(); ++d) {
+            best[d] = best_bid(d);
+        }
+        std::vector<TimedAssignment> result;
+        std::vector<bool> assigned(tasks.size(), false);
+        for (size_t round{0}; round < tasks.size(); ++round) {
+            size_t best_delivery{tasks.size()};
+            for (size_t d{0}; d < tasks.size(); ++d) {
+                if (!assigned[d] && (best_delivery == tasks.size() || best[d].finish < best[best_delivery].finish)) {
+                    best_delivery = d;
+                }
+            }
+            const auto winner = best[best_delivery].robot;
+            assigned[best_delivery] = true;
+            finish_time.assign(winner, best_delivery, result);
+
+            for (size_t d{0}; d < tasks.size(); ++d) {
+                if (assigned[d]) {
+                    continue;
+                }
+                if (best[d].robot == winner) {
+                    // its bid went up, another robot may be ahead now
+                    best[d] = best_bid(d);
+                } else {
+                    // ties go to the robot listed first
+                    const auto finish = finish_time(winner, d);
+                    if (finish < best[d].finish || (finish == best[d].finish && winner < best[d].robot)) {
+                        best[d] = {finish, winner};
+                    }
+                }
+            }
+        }
+        return result;
+    }
+
+    /*
+     * Some optimal assignment only uses columns that are among the rows cheapest ones of their row: a row assigned to
+     * any other column could take one of those instead, the other rows hold at most rows - 1 of them.
+     * @return the columns that are among the rows cheapest ones of any row, ascending
+     */
+    std::vector<size_t> cheapest_columns(const std::vector<std::vector<int64_t>> &cost) {
+        const auto rows = cost.size();
+        const auto columns = rows == 0 ? 0 : cost[0].size();
+        std::vector<size_t> kept;
+        if (rows >= columns) {
+            for (size_t j{0}; j < columns; ++j) {
+                kept.push_back(j);
+            }
+            return kept;
+        }
+        std::vector<bool> keep(columns, false);
+        std::vector<int64_t> row;
+        for (const auto &c : cost) {
+            row = c;
+            std::nth_element(row.begin(), row.begin() + static_cast<std::ptrdiff_t>(rows - 1), row.end());
+            const auto limit = row[rows - 1];
+            for (size_t j{0}; j < columns; ++j) {
+                keep[j] = keep[j] || c[j] <= limit;
+            }
+        }
+        for (size_t j{0}; j < columns; ++j) {
+            if (keep[j]) {
+                kept.push_back(j);
+            }
+        }
+        return kept;
+    }
+
+    std::vector<TimedAssignment> hungarian_rounds(std::vector<RobotEstimate> &robots,
+                                                  const std::vector<DeliveryTask> &tasks,
+                                                  const DistanceTable &distances) {
+        FinishTimes finish_time(robots, tasks, distances);
+        std::vector<TimedAssignment> result;
+        std::vector<size_t> open(tasks.size());
+        for (size_t d{0}; d < tasks.size(); ++d) {
+            open[d] = d;
+        }
+
+        // every round each robot gets at most one delivery, the matching minimizes the summed finish times
+        while (!open.empty()) {
+            const bool robots_are_rows = robots.size() <= open.size();
+            const auto rows = robots_are_rows ? robots.size() : open.size();
+            const auto columns = robots_are_rows ? open.size() : robots.size();
+
+            std::vector<std::vector<int64_t>> cost(rows, std::vector<int64_t>(columns));
+            for (size_t i{0}; i < rows; ++i) {
+                for (size_t j{0}; j < columns; ++j) {
+                    const auto r = robots_are_rows ? i : j;
+                    const auto d = robots_are_rows ? j : i;
+                    cost[i][j] = finish_time(r, open[d]);
+                }
+            }
+
+            const auto kept = cheapest_columns(cost);
+            for (auto &row : cost) {
+                for (size_t j{0}; j < kept.size(); ++j) {
+                    row[j] = row[kept[j]];
+                }
+                row.resize(kept.size());
+            }
+            const auto matching = hungarian(cost);
+            std::vector<bool> done(open.size(), false);
+            for (size_t i{0}; i < rows; ++i) {
+                const auto r = robots_are_rows ? i : kept[matching[i]];
+                const auto d = robots_are_rows ? kept[matching[i]] : i;
+                finish_time.assign(r, open[d], result);
+                done[d] = true;
+            }
+
+            std::vector<size_t> still_open;
+            for (size_t d{0}; d < open.size(); ++d) {
+                if (!done[d]) {
+                    still_open.push_back(open[d]);
+                }
+            }
+            open.swap(still_open);
+        }
+        return result;
+    }
+}
+
+int32_t estimate_delivery_time(SpacePoint from, const DeliveryTask &task, const DistanceTable &distances) {
+    const int32_t to_start = distances.distance(task.start, from);
+    return 2 * to_start + time_from_start(task, distances);
+}
+
+std::vector<Assignment> allocate_deliveries(AllocationKind kind, const std::vector<RobotState> &robots,
+                                            const std::vector<DeliveryTask> &tasks, const DistanceTable &distances) {
+    std::vector<Assignment> result;
+    if (kind == AllocationKind::Greedy || robots.empty()) {
+        for (size_t d{0}; d < tasks.size(); ++d) {
+            result.push_back({d, -1});
+        }
+        return result;
+    }
+
+    std::vector<RobotEstimate> estimates;
+    for (const auto &r : robots) {
+        estimates.push_back({r.id, SpacePoint(r.endpoint), r.endpoint.t});
+    }
+    auto timed = kind == AllocationKind::Auction ? auction(estimates, tasks, distances)
+                                                 : hungarian_rounds(estimates, tasks, distances);
+
+    // plan in the order the robots will (roughly) start working on the deliveries
+    std::stable_sort(timed.begin(), timed.end(), [](const TimedAssignment &a1, const TimedAssignment &a2) {
+        return a1.start < a2.start;
+    });
+    for (const auto &t : timed) {
+        result.push_back(t.assignment);
+    }
+    return result;
+}
+
+std::vector<size_t> hungarian(const std::vector<std::vector<int64_t>> &cost) {
+    // Kuhn-Munkres with potentials, O(rows^2 * columns). Rows and columns are 1-indexed internally, 0 is a dummy.
+    const auto rows = cost.size();
+    const auto columns = rows == 0 ? 0 : cost[0].size();
+    const auto inf = std::numeric_limits<int64_t>::max() / 4;
+
+    std::vector<int64_t> u(rows + 1, 0);
+    std::vector<int64_t> v(columns + 1, 0);
+    std::vector<size_t> row_of(columns + 1, 0);
+    std::vector<size_t> way(columns + 1, 0);
+
+    for (size_t i{1}; i <= rows; ++i) {
+        row_of[0] = i;
+        size_t j0{0};
+        std::vector<int64_t> min_v(columns + 1, inf);
+        std::vector<bool> used(columns + 1, false);
+        do {
+            used[j0] = true;
+            const auto i0 = row_of[j0];
+            auto delta = inf;
+            size_t j1{0};
+            for (size_t j{1}; j <= columns; ++j) {
+                if (used[j]) {
+                    continue;
+                }
+                const auto reduced = cost[i0 - 1][j - 1] - u[i0] - v[j];
+                if (reduced < min_v[j]) {
+                    min_v[j] = reduced;
+                    way[j] = j0;
+                }
+                if (min_v[j] < delta) {
+                    delta = min_v[j];
+                    j1 = j;
+                }
+            }
+            for (size_t j{0}; j <= columns; ++j) {
+                if (used[j]) {
+                    u[row_of[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    min_v[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (row_of[j0] != 0);
+
+        do {
+            const auto j1 = way[j0];
+            row_of[j0] = row_of[j1];
+            j0 = j1;
+        } while (j0 != 0);
+    }
+
+    std::vector<size_t> column_of_row(rows, 0);
+    for (size_t j{1}; j <= columns; ++j) {
+        if (row_of[j] != 0) {
+            column_of_row[row_of[j] - 1] = j - 1;
+        }
+    }
+    return column_of_row;
+}
@@ -0,0 +1,39 @@
+#ifndef MAPF_TASK_ALLOCATION_H
+#define MAPF_TASK_ALLOCATION_H
+
+#include <vector>
+
+#include "delivery_planning.h"
+
+enum class AllocationKind {
+    Greedy,   // deliveries in file order, each goes to the robot that finishes it first
+    Auction,  // sequential auction, the (robot, delivery) pair finishing earliest is assigned next
+    Hungarian // rounds of optimal one delivery per robot matchings
+};
+
+struct Assignment {
+    size_t delivery; // index into the task list
+    int32_t robot_id;
+};
+
+/*
+ * Estimated time for a robot standing at from with a full battery to do task, including both recharges.
+ * Other robots are ignored, distances come from the distance fields.
+ */
+int32_t estimate_delivery_time(SpacePoint from, const DeliveryTask &task, const DistanceTable &distances);
+
+/*
+ * Decides which robot does which delivery before any path is planned, by looking at all deliveries at once.
+ * @return every task exactly once, ordered by the estimated time the assigned robot starts on it, which is the order
+ *         the deliveries should be planned in. For AllocationKind::Greedy the file order is kept and robot_id is -1.
+ */
+std::vector<Assignment> allocate_deliveries(AllocationKind kind, const std::vector<RobotState> &robots,
+                                            const std::vector<DeliveryTask> &tasks, const DistanceTable &distances);
+
+/*
+ * Solves the rectangular assignment problem for cost (rows <= columns), every row gets a different column.
+ * @return the column assigned to each row, minimizing the summed cost
+ */
+std::vector<size_t> hungarian(const std::vector<std::vector<int64_t>> &cost);
+
+#endif //MAPF_TASK_ALLOCATION_H
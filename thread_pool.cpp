@@ -0,0 +1,77 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(size_t threads)
+        : m_job{nullptr}, m_count{0}, m_next{0}, m_running{0}, m_generation{0}, m_stop{false} {
+    for (size_t i{1}; i < threads; ++i) {
+        m_workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto &w : m_workers) {
+        w.join();
+    }
+}
+
+size_t ThreadPool::size() const noexcept {
+    return m_workers.size() + 1;
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void(size_t)> &job) {
+    if (m_workers.empty() || n <= 1) {
+        for (size_t i{0}; i < n; ++i) {
+            job(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_count = n;
+        m_next = 0;
+        m_running = m_workers.size();
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    run_jobs();
+
+    // every worker has to check in, otherwise one of them could still pick up an index of this loop later on
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_running == 0; });
+    m_job = nullptr;
+}
+
+void ThreadPool::worker_loop() {
+    uint64_t seen_generation{0};
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen_generation; });
+            if (m_stop) {
+                return;
+            }
+            seen_generation = m_generation;
+        }
+
+        run_jobs();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_running;
+        }
+        m_done.notify_one();
+    }
+}
+
+void ThreadPool::run_jobs() {
+    for (auto i = m_next++; i < m_count; i = m_next++) {
+        (*m_job)(i);
+    }
+}
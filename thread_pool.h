@@ -0,0 +1,52 @@
+#ifndef MAPF_THREAD_POOL_H
+#define MAPF_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Fixed set of worker threads for data parallel loops. The calling thread takes part in every loop, so a pool of
+ * size 1 has no workers and runs everything inline.
+ *
+ * There is no work stealing: all threads take the next index of a loop from one shared atomic counter, one at a time.
+ * That balances loops of uneven jobs as long as there are more jobs than threads and each job outweighs the counter.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t size() const noexcept;
+
+    /*
+     * Calls job(i) for every i in [0, n) spread over all threads and returns once all calls are done.
+     * Must not be called from within a job.
+     */
+    void parallel_for(size_t n, const std::function<void(size_t)> &job);
+
+private:
+    void worker_loop();
+
+    void run_jobs();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const std::function<void(size_t)> *m_job;
+    size_t m_count;
+    std::atomic<size_t> m_next;
+    size_t m_running;
+    uint64_t m_generation;
+    bool m_stop;
+};
+
+#endif //MAPF_THREAD_POOL_H
@@ -0,0 +1,288 @@
+#include "windowed.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+#include "compact_path.h"
+#include "delivery_planning.h"
+#include "distance_table.h"
+#include "reservation_table.h"
+#include "search_context.h"
+#include "task_allocation.h"
+
+namespace {
+    /* A place a robot has to get to: a shelf to load or unload at, or any charger.
+     */
+    struct Stop {
+        const uint16_t *field; // distance field whose zeros are the goals
+        char action;           // package id written while loading or unloading, 0 for recharging
+    };
+
+    /* Where a robot is in working through its stops.
+     */
+    struct Progress {
+        SpaceTimePoint p;
+        int32_t charge;
+        size_t next;        // index of the next stop
+        int32_t rest_left;  // steps still to stay at the stop reached last
+        char rest_action;
+        int32_t done_at;    // time the last stop was done, -1 until then
+    };
+
+    struct Step {
+        SpaceTimePoint p;
+        char action;
+    };
+
+    struct WindowRobot {
+        int32_t id;
+        std::vector<Stop> stops;
+        Progress progress;
+        std::string moves;
+        std::vector<SpaceTimePoint> reserved; // everything of this robot that is in the reservations
+        std::vector<Step> steps;              // the plan of the current window
+    };
+
+    /*
+     * Plans a robot from state up to window_end around the reservations, starting with the rest it is in. Robots
+     * without stops left keep out of the way.
+     * @return false if the robot can't even stay where it is, otherwise steps holds one step per time step and
+     *         committed the robot after time step commit
+     */
+    bool plan_window(const std::vector<Stop> &stops, Progress state, int32_t window_end, int32_t commit,
+                     int32_t full_charge, const ReservationTable &reservations, const DistanceTable &distances,
+                     std::mt19937 &rng, std::vector<Step> &steps, Progress &committed) {
+        steps.clear();
+        const auto width = static_cast<size_t>(distances.width());
+        const auto snapshot = [&]() {
+            if (state.done_at < 0 && state.next == stops.size() && state.rest_left == 0) {
+                state.done_at = state.p.t;
+            }
+            if (state.p.t == commit) {
+                committed = state;
+            }
+        };
+
+        while (state.p.t < window_end) {
+            snapshot();
+            if (state.rest_left > 0) {
+                --state.rest_left;
+                if (state.rest_action == 'S') {
+                    state.charge = std::min(full_charge, state.charge + 1);
+                }
+                state.p.t += 1;
+                steps.push_back({state.p, state.rest_action});
+                continue;
+            }
+
+            CompactPath path;
+            const Stop *stop = state.next < stops.size() ? &stops[state.next] : nullptr;
+            if (stop) {
+                // waiting is part of the search, so there is nothing else to try if it fails
+                path = a_star_windowed(state.p, stop->field, stop->action ? 1 : -1, state.charge, full_charge,
+                                       window_end - state.p.t, reservations, distances, default_search_context());
+                if (path.empty()) {
+                    return false;
+                }
+            } else if (!find_actions(state.p, state.charge, window_end - state.p.t - 1, reservations, rng, path)) {
+                return false;
+            }
+            const auto arrived = stop && stop->field[static_cast<size_t>(path.back().y) * width + path.back().x] == 0;
+
+            for (size_t k{0}; k < path.moves(); ++k) {
+                const auto move = path.move(k);
+                state.charge -= move == Move::Rest ? 0 : 1;
+                state.p = apply_move(state.p, move);
+                steps.push_back({state.p, move_to_char(move)});
+                if (k + 1 < path.moves()) {
+                    snapshot();
+                }
+            }
+            if (arrived) {
+                state.rest_action = stop->action ? stop->action : 'S';
+                state.rest_left = stop->action ? 1 : full_charge - state.charge;
+                ++state.next;
+            }
+        }
+        snapshot();
+        return true;
+    }
+}
+
+bool solve_windowed(const Instance &inst, const DistanceTable &distances, const Options &options,
+                    MoveStrings &move_strings) {
+    SolveVariant variant;
+    variant.seed = std::random_device{}();
+    return solve_windowed(inst, distances, options, variant, move_strings);
+}
+
+bool solve_windowed(const Instance &inst, const DistanceTable &distances, const Options &options,
+                    const SolveVariant &variant, MoveStrings &move_strings) {
+    const auto &grid = *distances.grid();
+    const auto window = std::max(options.window, 1);
+    const auto commit_steps = std::max(window / 2, 1);
+
+    // allocate all deliveries up front, the greedy allocation leaves picking the robots to us
+    std::vector<RobotState> robot_states;
+    for (const auto &p : inst.robot_positions) {
+        robot_states.push_back({p.first, inst.charge, SpaceTimePoint(p.second)});
+    }
+    std::vector<DeliveryTask> tasks;
+    for (const auto &d : inst.deliveries) {
+        tasks.push_back(make_delivery_task(d, inst, distances));
+    }
+    const auto assignments = allocate_deliveries(options.allocation, robot_states, tasks, distances);
+
+    std::vector<WindowRobot> robots;
+    for (const auto &r : robot_states) {
+        robots.push_back({r.id, {}, {r.endpoint, r.charge, 0, 0, 'S', -1}, {}, {}, {}});
+    }
+    const auto charger_field = distances.charger_field();
+    for (const auto &assignment : assignments) {
+        const auto &task = tasks[assignment.delivery];
+        const auto finish = [&](size_t k) {
+            const auto from = robot_states[k].endpoint;
+            return from.t + estimate_delivery_time(SpacePoint(from), task, distances);
+        };
+        size_t r{0};
+        if (assignment.robot_id >= 0) {
+            r = static_cast<size_t>(grid.robot_index(assignment.robot_id));
+        } else {
+            // the robot that would be done with it first, by the estimates
+            for (size_t k{1}; k < robots.size(); ++k) {
+                if (finish(k) < finish(r)) {
+                    r = k;
+                }
+            }
+        }
+        robot_states[r].endpoint = SpaceTimePoint(task.charger_2, finish(r));
+
+        const auto start_field = distances.field(task.start);
+        const auto goal_field = distances.field(task.goal);
+        if (!start_field || !goal_field) {
+            std::cout << "Windowed: no distance field towards the shelves of package " << task.delivery.id << "\n";
+            return false;
+        }
+        robots[r].stops.push_back({start_field, task.delivery.id});
+        if (charger_field) {
+            robots[r].stops.push_back({charger_field, 0});
+        }
+        robots[r].stops.push_back({goal_field, task.delivery.id});
+        if (charger_field) {
+            robots[r].stops.push_back({charger_field, 0});
+        }
+    }
+    for (auto &r : robots) {
+        r.progress.done_at = r.stops.empty() ? 0 : -1;
+    }
+
+    ReservationTable reservations(distances.grid());
+    std::mt19937 rng{variant.seed};
+    // if nobody gets to a stop for that long, nobody ever will
+    const int32_t stall_limit = 8 * (grid.width() + grid.height()) + 2 * inst.charge;
+    int32_t now{0};
+    int32_t last_progress{0};
+    size_t round{0};
+    std::vector<Progress> committed(robots.size());
+    std::vector<size_t> order;
+    const auto all_done = [&robots]() {
+        return std::all_of(robots.begin(), robots.end(), [](const WindowRobot &r) {
+            return r.progress.done_at >= 0;
+        });
+    };
+
+    while (!all_done()) {
+        if (now - last_progress > stall_limit) {
+            std::cout << "Windowed: the robots got stuck at time " << now << "\n";
+            return false;
+        }
+
+        // Give back the last window, every robot only keeps its current field and the fields it rests on
+        const auto window_end = now + window;
+        const auto give_back = [&]() {
+            for (auto &r : robots) {
+                for (const auto p : r.reserved) {
+                    reservations.release(p);
+                }
+                r.reserved.assign(1, r.progress.p);
+                for (int32_t k{1}; k <= std::min(r.progress.rest_left, window); ++k) {
+                    r.reserved.emplace_back(r.progress.p.x, r.progress.p.y, now + k);
+                }
+                for (const auto p : r.reserved) {
+                    reservations.reserve(p);
+                }
+            }
+        };
+        give_back();
+        reservations.drop_before(now);
+
+        // the priorities rotate, so nobody is always the one to give way
+        order.clear();
+        for (size_t k{0}; k < robots.size(); ++k) {
+            const auto r = (k + round) % robots.size();
+            if (robots[r].progress.done_at < 0) {
+                order.push_back(r);
+            }
+        }
+        for (size_t r{0}; r < robots.size(); ++r) {
+            if (robots[r].progress.done_at >= 0) {
+                order.push_back(r);
+            }
+        }
+
+        // A robot that gets boxed in by those before it goes first in the next try, every robot gets one
+        for (size_t tries{0}, k{0}; k < order.size(); ++k) {
+            auto &robot = robots[order[k]];
+            for (const auto p : robot.reserved) {
+                reservations.release(p);
+            }
+            if (!plan_window(robot.stops, robot.progress, window_end, now + commit_steps, inst.charge, reservations,
+                             distances, rng, robot.steps, committed[order[k]])) {
+                if (k == 0 || ++tries > robots.size()) {
+                    std::cout << "Windowed: robot " << robot.id << " is stuck at time " << now << "\n";
+                    return false;
+                }
+                std::rotate(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(k),
+                            order.begin() + static_cast<std::ptrdiff_t>(k) + 1);
+                give_back();
+                k = static_cast<size_t>(-1);
+                continue;
+            }
+            robot.reserved.assign(1, robot.progress.p);
+            for (const auto &step : robot.steps) {
+                robot.reserved.push_back(step.p);
+            }
+            for (const auto p : robot.reserved) {
+                reservations.reserve(p);
+            }
+        }
+
+        // carry out the first half of the window
+        for (size_t r{0}; r < robots.size(); ++r) {
+            auto &robot = robots[r];
+            for (int32_t k{0}; k < commit_steps; ++k) {
+                robot.moves.push_back(robot.steps[static_cast<size_t>(k)].action);
+            }
+            if (committed[r].next != robot.progress.next || committed[r].done_at != robot.progress.done_at) {
+                last_progress = now + commit_steps;
+            }
+            robot.progress = committed[r];
+        }
+        now += commit_steps;
+        ++round;
+    }
+
+    // the last rounds may have run past the end of the last delivery
+    int32_t makespan{0};
+    for (const auto &r : robots) {
+        makespan = std::max(makespan, r.progress.done_at);
+    }
+    move_strings.clear();
+    for (auto &r : robots) {
+        r.moves.resize(static_cast<size_t>(makespan));
+        move_strings.emplace_back(r.id, std::move(r.moves));
+    }
+    std::cout << "Windowed: all deliveries done after " << round << " rounds of " << commit_steps << " steps\n";
+    return true;
+}
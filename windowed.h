@@ -0,0 +1,29 @@
+#ifndef MAPF_WINDOWED_H
+#define MAPF_WINDOWED_H
+
+#include "input_parsing.h"
+#include "options.h"
+#include "solver.h"
+
+class DistanceTable;
+
+/*
+ * Windowed cooperative planning (WHCA*). The deliveries are allocated up front, each robot then works through its
+ * stops: start shelf, a charger, goal shelf, a charger. Time advances in rounds of options.window / 2 steps, in every
+ * round each robot plans the next options.window steps with a_star_windowed around the robots before it, and only
+ * those steps are reserved. Beyond the window the robots follow the distance fields, so the cost of a round and the
+ * size of the reservations don't grow with the makespan. The order of the robots rotates from round to round, robots
+ * without stops left come last and only keep out of the way. Uses a random seed.
+ * @return false if the robots got stuck, the reason has been printed already
+ */
+bool solve_windowed(const Instance &inst, const DistanceTable &distances, const Options &options,
+                    MoveStrings &move_strings);
+
+/*
+ * Same as above, with the seed of find_actions taken from variant, which the windowed solve is not varied in
+ * otherwise.
+ */
+bool solve_windowed(const Instance &inst, const DistanceTable &distances, const Options &options,
+                    const SolveVariant &variant, MoveStrings &move_strings);
+
+#endif //MAPF_WINDOWED_H